@@ -3,18 +3,21 @@
 
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec2 texCoord;
+layout(location = 2) in float layer;
 
 uniform mat4 u_ModelMatrix;
 uniform mat4 u_ViewMatrix;
 uniform mat4 u_ProjectionMatrix;
 
 out vec2 v_TexCoord;
+flat out float v_Layer;
 
 void main() {
     mat4 MVP = u_ProjectionMatrix * u_ViewMatrix * u_ModelMatrix;
     gl_Position = MVP * position;
 
     v_TexCoord = texCoord;
+    v_Layer = layer;
 }
 
 #shader fragment
@@ -25,6 +28,10 @@ layout(location = 0) out vec4 color;
 uniform sampler2D u_Texture;
 uniform float u_ModeFactor;
 
+// Set when the model has materials, they replace u_Texture.
+uniform sampler2DArray u_Materials;
+uniform bool u_UseMaterials;
+
 uniform sampler2D u_DissolveTexture;
 uniform float u_DissolveAmount;
 uniform float u_BurnSize = 0.15f;
@@ -33,6 +40,7 @@ uniform float u_BurnBrightness = 0.7f;
 const float SMALL_NUMBER = 0.0001f;
 
 in vec2 v_TexCoord;
+flat in float v_Layer;
 
 // https://agatedragon.blog/2025/10/31/creating-a-dissolve-shader/
 
@@ -44,7 +52,8 @@ void main() {
 
     vec3 baseGray = vec3(grayShade);
 
-    vec3 textureColor = texture(u_Texture, v_TexCoord).rgb;
+    vec3 textureColor = u_UseMaterials ? texture(u_Materials, vec3(v_TexCoord, v_Layer)).rgb
+                                       : texture(u_Texture, v_TexCoord).rgb;
 
     // Mix allows us to make a color more "visible" than the other, so when its set to 1.0f,
     // we will see the texture.
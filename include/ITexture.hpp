@@ -10,4 +10,11 @@ class ITexture
     virtual void Bind(uint32_t = 0) const = 0;
     virtual uint32_t GetWidth() const = 0;
     virtual uint32_t GetHeight() const = 0;
+
+    // False while a texture loaded in the background still shows its
+    // placeholder.
+    virtual bool IsReady() const
+    {
+        return true;
+    }
 };
\ No newline at end of file
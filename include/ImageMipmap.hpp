@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Mip chains built on the CPU, so loads on worker threads can hand the driver
+// every level instead of having it stall in glGenerateMipmap.
+//
+// Color channels are sRGB encoded: averaging them as they are darkens every
+// level, ex: black and white pixels give 128 where the light reaching the eye
+// averages to 188. They are averaged in linear space instead, alpha as it is.
+// http://www.ericbrasseur.org/gamma.html
+
+struct MipLevel
+{
+    uint32_t width;
+    uint32_t height;
+    // Of the first byte of the level in the chain.
+    std::size_t offset;
+};
+
+// Levels from width x height down to 1x1, each half the size of the previous
+// one rounded down, packed one after the other.
+std::vector<MipLevel> GetMipLevels(uint32_t width, uint32_t height, int channels);
+std::size_t GetMipChainSize(std::span<const MipLevel> levels, int channels);
+
+// Build levels 1 and up from level 0 in `base`, with a 2x2 box filter. Odd
+// sizes drop their last row or column. The chain is only written, never read,
+// so `chain` can be a mapped pixel buffer. It can also be the same memory as
+// `base`.
+void BuildMipChain(const unsigned char* base, std::span<const MipLevel> levels, int channels, unsigned char* chain);
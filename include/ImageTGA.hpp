@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// TGA decoding, shared by single textures and texture arrays. Files are mapped
+// rather than read, and pixels are swizzled from BGR(A) with SIMD where the CPU
+// has it: SSE2 and SSSE3 on x86, NEON on ARM.
+//
+// https://www.gamers.org/dEngine/quake3/TGA.txt
+// https://www.ryanjuckett.com/parsing-colors-in-a-tga-file/
+
+// Decodes producing at least this many bytes print their throughput.
+constexpr std::size_t TGA_REPORT_MIN_SIZE = 4 * 1024 * 1024;
+
+struct tImageTGA
+{
+    std::vector<unsigned char> data;
+    int channels;
+    int sizeX;
+    int sizeY;
+};
+
+// Decode to RGB or RGBA rows, 3 or 4 channels, bottom row first. 16-bit files
+// decode to opaque RGBA.
+// https://nehe.gamedev.net/tutorial/loading_compressed_and_uncompressed_tga%27s/22001/
+tImageTGA LoadTGA(const std::string& filename);
+
+// Same from a file already in memory.
+tImageTGA DecodeTGA(const unsigned char* file, std::size_t size);
+
+// What the header says, checked against the file size.
+struct TGAInfo
+{
+    int sizeX;
+    int sizeY;
+    // Of the decoded pixels, 3 or 4.
+    int channels;
+    // Of the pixels in the file, 16, 24 or 32.
+    int bits;
+    bool compressed;
+    std::size_t dataOffset;
+
+    inline std::size_t GetDecodedSize() const
+    {
+        return static_cast<std::size_t>(sizeX) * sizeY * channels;
+    }
+};
+
+// Split in two so the caller can choose where the pixels go, ex: a mapped pixel
+// buffer object. `output` must hold info.GetDecodedSize() bytes.
+TGAInfo ReadTGAInfo(const unsigned char* file, std::size_t size);
+void DecodeTGA(const unsigned char* file, std::size_t size, const TGAInfo& info, unsigned char* output);
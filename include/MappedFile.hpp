@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. Pages are loaded lazily by the
+// kernel, so parsers can tokenize straight from the mapping instead of copying
+// every line into a std::string first.
+class MappedFile
+{
+    public:
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline const char* GetData() const
+    {
+        return _data;
+    }
+
+    inline std::size_t GetSize() const
+    {
+        return _size;
+    }
+
+    inline std::string_view GetView() const
+    {
+        return std::string_view(_data, _size);
+    }
+
+    private:
+    const char* _data;
+    std::size_t _size;
+};
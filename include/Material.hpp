@@ -0,0 +1,25 @@
+#pragma once
+
+#include "math/vector.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Submeshes whose usemtl names no material of the loaded libraries.
+constexpr uint32_t NO_MATERIAL = std::numeric_limits<uint32_t>::max();
+
+// The part of a .mtl material the renderer uses: its diffuse color, or its
+// diffuse texture when it has one.
+// https://paulbourke.net/dataformats/mtl/
+struct Material
+{
+    std::string name;
+    Vector3 diffuse = Vector3(1, 1, 1);
+    // Resolved against the directory of the .mtl file, empty without map_Kd.
+    std::string diffuseMap;
+};
+
+// Append the materials of a .mtl file. A material defined twice keeps its
+// first definition, as in most OBJ viewers.
+void LoadMaterialLibrary(const std::string& filename, std::vector<Material>& materials);
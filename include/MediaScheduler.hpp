@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A jump of the clock longer than this, in seconds, is a seek: the frames it
+// skips are not counted as dropped.
+constexpr double MEDIA_SEEK_THRESHOLD = 1.0;
+
+enum class MediaClock
+{
+    // Position of the audio, given every frame by SetAudioTime.
+    AUDIO,
+    // Time between frames added up, when no audio position is given.
+    MONOTONIC,
+};
+
+// Decides which frame of a video is due from a single master clock, and
+// counts how the frames actually presented kept up with it:
+// - dropped: frames never presented, skipped by the clock or replaced by the
+//   next one before they were ready;
+// - late: frames presented, but after the first frame they were due;
+// - repeated: rendered frames showing an older frame in place of the due one.
+// A slow render loop skips frames rather than showing every one of them late.
+class MediaScheduler
+{
+    public:
+    // `frameCount` at least 1. The monotonic clock loops over the video, the
+    // audio clock stops at its last frame.
+    MediaScheduler(double frameRate, std::size_t frameCount);
+
+    // While paused neither clock advances.
+    inline void SetPlaying(bool playing)
+    {
+        _playing = playing;
+    }
+
+    inline bool IsPlaying() const
+    {
+        return _playing;
+    }
+
+    // Master clock for the next Update only, the monotonic clock goes on from
+    // there when no position is given.
+    void SetAudioTime(double seconds);
+
+    // Once per rendered frame, return the frame due.
+    std::size_t Update(double deltaTime);
+
+    // The frame on screen this rendered frame, after Update.
+    void Present(std::size_t frame);
+
+    inline MediaClock GetClock() const
+    {
+        return _clock;
+    }
+
+    inline uint64_t GetDroppedCount() const
+    {
+        return _droppedCount;
+    }
+
+    inline uint64_t GetLateCount() const
+    {
+        return _lateCount;
+    }
+
+    inline uint64_t GetRepeatedCount() const
+    {
+        return _repeatedCount;
+    }
+
+    private:
+    double _frameRate;
+    std::size_t _frameCount;
+    MediaClock _clock = MediaClock::MONOTONIC;
+    double _time = 0.0;
+    double _audioTime = 0.0;
+    bool _hasAudioTime = false;
+    bool _playing = false;
+
+    std::size_t _dueFrame = 0;
+    // Rendered frames since _dueFrame became due, and whether it was shown.
+    uint64_t _dueTicks = 0;
+    bool _duePresented = false;
+
+    uint64_t _droppedCount = 0;
+    uint64_t _lateCount = 0;
+    uint64_t _repeatedCount = 0;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Material.hpp"
+#include "MeshBvh.hpp"
+#include "MeshTypes.hpp"
+#include "math/vector.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Model;
+
+// What the renderer keeps of a model once its buffers are on the GPU: bounds,
+// levels of detail, meshlets, submeshes, materials and the BVH. The vertex and index
+// buffers, and everything the parser needed to build them, are released with
+// the Model it is built from.
+class Mesh
+{
+    public:
+    // `keepPositions` keeps the positions and the full detail triangles, for
+    // picking on the CPU.
+    explicit Mesh(Model&& model, bool keepPositions = false);
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    inline const Vector3& GetCentroid() const
+    {
+        return _centroid;
+    }
+
+    inline const Vector3& GetBoundsMin() const
+    {
+        return _boundsMin;
+    }
+
+    inline const Vector3& GetBoundsMax() const
+    {
+        return _boundsMax;
+    }
+
+    inline const Vector3& GetSphereCenter() const
+    {
+        return _sphereCenter;
+    }
+
+    inline float GetSphereRadius() const
+    {
+        return _sphereRadius;
+    }
+
+    inline uint32_t GetIndexCount() const
+    {
+        return _indexCount;
+    }
+
+    inline std::span<const MeshLod> GetLods() const
+    {
+        return _lods;
+    }
+
+    inline std::span<const Meshlet> GetMeshlets() const
+    {
+        return _meshlets;
+    }
+
+    inline std::span<const Submesh> GetSubmeshes() const
+    {
+        return _submeshes;
+    }
+
+    inline const MeshRange& GetSubmeshRange(std::size_t level, std::size_t submesh) const
+    {
+        return _submeshRanges[level * _submeshes.size() + submesh];
+    }
+
+    std::string_view GetSubmeshName(std::size_t submesh) const;
+    std::string_view GetSubmeshMaterial(std::size_t submesh) const;
+    // Submesh holding a triangle of level 0.
+    std::size_t FindSubmesh(uint32_t triangle) const;
+
+    inline std::span<const Material> GetMaterials() const
+    {
+        return _materials;
+    }
+
+    // Index in GetMaterials, or NO_MATERIAL.
+    inline uint32_t GetSubmeshMaterialIndex(std::size_t submesh) const
+    {
+        return _submeshMaterials[submesh];
+    }
+
+    // Empty unless built with `keepPositions`.
+    inline std::span<const Vector3> GetPositions() const
+    {
+        return _positions;
+    }
+
+    inline std::span<const uint32_t> GetTriangles() const
+    {
+        return _triangles;
+    }
+
+    // Null unless the model was loaded with buildBvh. Built on the first call,
+    // which releases the vertices and triangles kept for it.
+    const MeshBvh* GetBvh();
+
+    // Bytes held by this object, to compare with the model it replaced.
+    std::size_t GetMemoryUsage() const;
+
+    private:
+    Vector3 _centroid;
+    Vector3 _boundsMin;
+    Vector3 _boundsMax;
+    Vector3 _sphereCenter;
+    float _sphereRadius;
+    uint32_t _indexCount;
+
+    std::vector<MeshLod> _lods;
+    std::vector<Meshlet> _meshlets;
+    std::vector<Submesh> _submeshes;
+    std::vector<MeshRange> _submeshRanges;
+    std::string _submeshStrings;
+    std::vector<Material> _materials;
+    std::vector<uint32_t> _submeshMaterials;
+
+    std::vector<Vector3> _positions;
+    std::vector<uint32_t> _triangles;
+
+    // Interleaved like the vertex buffer, and the full detail triangles, until
+    // the BVH is built.
+    std::vector<float> _bvhVertices;
+    std::vector<uint32_t> _bvhTriangles;
+    uint32_t _bvhThreadCount;
+    std::unique_ptr<MeshBvh> _bvh;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "math/vector.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Bounding volume hierarchy over the triangles of a mesh, for picking and ray
+// queries on the CPU. Nodes are split with the surface area heuristic on
+// binned centroids, and the top of the tree is built by several threads.
+//
+// https://jacco.ompf2.com/2022/04/13/how-to-build-a-bvh-part-1-basics/
+// https://www.sci.utah.edu/~wald/Publications/2007/ParallelBVHBuild/fastbuild.pdf
+
+// Candidate split planes per axis.
+constexpr uint32_t BVH_BIN_COUNT = 16;
+// A node with more triangles is always split, if its centroids allow it.
+constexpr uint32_t BVH_MAX_LEAF_SIZE = 8;
+// Subtrees smaller than this are built by the thread that split their parent.
+constexpr uint32_t BVH_PARALLEL_MIN_TRIANGLES = 64 * 1024;
+
+// 32 bytes, two nodes per cache line.
+struct BvhNode
+{
+    Vector3 boundsMin;
+    // First triangle of a leaf, or left child of an inner node, the right child
+    // follows it.
+    uint32_t first;
+    Vector3 boundsMax;
+    // 0 for an inner node.
+    uint32_t triangleCount;
+};
+
+struct RayHit
+{
+    // Index of the triangle in the index list the hierarchy was built from.
+    uint32_t triangle;
+    // Along the direction, in units of its length.
+    float distance;
+    // Barycentric weights of the second and third corners, the first one
+    // weighs 1 - u - v.
+    float u;
+    float v;
+    // Texture coordinates at the hit.
+    Vector2 uv;
+};
+
+class MeshBvh
+{
+    public:
+    // `vertices` holds a position and texture coordinates in its first 5 floats
+    // every `stride` floats.
+    MeshBvh(std::span<const uint32_t> indices, std::span<const float> vertices, std::size_t stride,
+            uint32_t threadCount);
+
+    // Closest triangle hit by origin + t * direction with 0 <= t <= maxDistance,
+    // both faces count. A segment from a to b is the ray a, b - a, with a
+    // maxDistance of 1.
+    bool Intersect(const Vector3& origin, const Vector3& direction, float maxDistance, RayHit& hit) const;
+
+    inline std::span<const BvhNode> GetNodes() const
+    {
+        return _nodes;
+    }
+
+    std::size_t GetMemoryUsage() const;
+
+    private:
+    // Precomputed for the Moller-Trumbore test, in leaf order.
+    struct Triangle
+    {
+        Vector3 v0;
+        Vector3 edge1;
+        Vector3 edge2;
+        uint32_t id;
+    };
+
+    std::vector<BvhNode> _nodes;
+    std::vector<Triangle> _triangles;
+    // Three per triangle, in the same order.
+    std::vector<Vector2> _uvs;
+};
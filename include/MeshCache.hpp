@@ -0,0 +1,100 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "MeshTypes.hpp"
+#include "math/vector.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Binary sidecar written next to an OBJ after its first load, ex:
+// "teapot.obj" -> "teapot.obj.meshcache". It holds the final interleaved
+// vertex buffer, index buffer, level of detail, meshlet and submesh tables, so
+// later loads skip parsing, triangulation and deduplication and hand the mapped
+// pages straight to the GPU.
+constexpr char MESH_CACHE_EXTENSION[] = ".meshcache";
+
+// Bump whenever the layout of the file or the content of the buffers changes.
+constexpr uint32_t MESH_CACHE_VERSION = 7;
+
+// Processing applied to the buffers after parsing. A cache written with other
+// load options is rebuilt rather than used.
+constexpr uint32_t MESH_CACHE_OPTIMIZED = 1u << 0;
+constexpr uint32_t MESH_CACHE_LODS = 1u << 1;
+constexpr uint32_t MESH_CACHE_MESHLETS = 1u << 2;
+constexpr uint32_t MESH_CACHE_WELDED = 1u << 3;
+
+// Identifies the exact source file a cache was built from.
+struct MeshCacheKey
+{
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+};
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    MeshCacheKey key;
+
+    uint64_t vertexFloatCount;
+    uint64_t indexCount;
+    uint64_t payloadHash;
+
+    Vector3 centroid;
+    Vector3 boundsMin;
+    Vector3 boundsMax;
+    Vector3 sphereCenter;
+    float sphereRadius;
+    uint32_t flags;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    // The submesh ranges hold lodCount * submeshCount entries.
+    uint32_t submeshCount;
+    uint32_t stringsSize;
+    // The mtllib file names, separated by newlines.
+    uint32_t librariesSize;
+    uint32_t reserved;
+};
+
+class Model;
+
+class MeshCache
+{
+    public:
+    static MeshCacheKey MakeKey(const std::string& sourcePath, const MappedFile& source);
+    static std::string GetCachePath(const std::string& sourcePath);
+
+    // Map the cache of `sourcePath`. Return nullptr if there is none, or if it is
+    // stale or corrupt, in which case the caller should parse the source.
+    static std::unique_ptr<MeshCache> Open(const std::string& sourcePath, const MeshCacheKey& key, uint32_t flags);
+
+    // Write the buffers of a freshly parsed model. Failing to write is not an
+    // error, the next load simply parses the source again.
+    static bool Write(const std::string& sourcePath, const MeshCacheKey& key, uint32_t flags, const Model& model);
+
+    std::span<const float> GetVertices() const;
+    std::span<const uint32_t> GetIndices() const;
+    std::span<const MeshLod> GetLods() const;
+    std::span<const Meshlet> GetMeshlets() const;
+    std::span<const Submesh> GetSubmeshes() const;
+    std::span<const MeshRange> GetSubmeshRanges() const;
+    std::string_view GetSubmeshStrings() const;
+    std::string_view GetMaterialLibraries() const;
+
+    inline const MeshCacheHeader& GetHeader() const
+    {
+        return _header;
+    }
+
+    private:
+    MeshCache(std::unique_ptr<MappedFile> file, const MeshCacheHeader& header);
+
+    std::unique_ptr<MappedFile> _file;
+    MeshCacheHeader _header;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "MeshTypes.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Split a triangle list in meshlets the renderer culls on the CPU before
+// drawing, and reorder the indices so every meshlet is a contiguous range.
+//
+// https://github.com/zeux/meshoptimizer#clusterization
+// https://advances.realtimerendering.com/s2015/aaltonenhaar_siggraph2015_combined_final_footer_220dpi.pdf
+
+// Most GPUs handle clusters of this size in a single wave.
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// Grow meshlets from connected triangles, preferring the ones that add the
+// fewest new vertices. Meshlet offsets are relative to the start of `indices`.
+// `vertices` holds positions in its first 3 floats every `stride` floats.
+std::vector<Meshlet> BuildMeshlets(std::span<uint32_t> indices, std::span<const float> vertices, std::size_t stride);
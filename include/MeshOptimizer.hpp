@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Triangle and vertex reordering run on a model once it is loaded, before the
+// index buffer is uploaded. They only change the order in which the GPU sees
+// the data, the rendered image stays the same.
+//
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+// https://gfx.cs.princeton.edu/pubs/Sander_2007_%3ETR/tipsy.pdf
+
+// Size of the FIFO post-transform cache used to measure the index order.
+constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats
+{
+    // Average cache miss ratio: transformed vertices per triangle, between 0.5
+    // and 3. Lower is better.
+    float acmr;
+    // Average transform to vertex ratio: transformed vertices per unique vertex,
+    // 1 is the best possible.
+    float atvr;
+};
+
+// Simulate a FIFO post-transform cache of VERTEX_CACHE_SIZE entries.
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, std::size_t vertexCount);
+
+// Reorder triangles so consecutive ones reuse the vertices that were just
+// transformed (Forsyth's linear-speed algorithm).
+void OptimizeVertexCache(std::span<uint32_t> indices, std::size_t vertexCount);
+
+// Split a cache optimized index list in clusters where the cache restarts anyway,
+// then draw the clusters facing outward first so they occlude the inner ones.
+// `vertices` holds positions in its first 3 floats every `stride` floats.
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const float> vertices, std::size_t stride);
+
+// Reorder vertices in the order the indices first reference them, so the vertex
+// fetch walks the buffer almost sequentially. Indices are remapped in place.
+void OptimizeVertexFetch(std::vector<float>& vertices, std::size_t stride, std::span<uint32_t> indices);
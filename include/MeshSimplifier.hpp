@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Simplify a triangle list down to about `targetIndexCount` indices with
+// quadric error metric edge collapses, reusing the existing vertices.
+// Vertices on a UV seam (a position shared by several vertices) or on an open
+// border are never moved, so texture charts stay intact and the silhouette of
+// open meshes is kept.
+// `vertices` holds positions in its first 3 floats every `stride` floats.
+// `error` receives the largest geometric error introduced, in model units.
+//
+// https://www.cs.cmu.edu/~./garland/Papers/quadrics.pdf
+std::vector<uint32_t> SimplifyMesh(std::span<const uint32_t> indices, std::span<const float> vertices,
+                                   std::size_t stride, std::size_t targetIndexCount, float& error);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Index lists to draw a triangle mesh as points or lines. glPolygonMode
+// rasterizes a vertex or an edge once per triangle using it, about 6 times per
+// vertex and twice per edge in a closed mesh. These lists hold each one once.
+
+// A range of an index list.
+struct IndexRange
+{
+    uint32_t offset;
+    uint32_t count;
+};
+
+// For each range of `triangles`, append the vertices it uses once each, in
+// order of first use, and the range they take to `output`. A vertex shared by
+// two ranges appears in both, so every range can be drawn on its own.
+std::vector<uint32_t> BuildPointIndices(std::span<const uint32_t> triangles, std::span<const IndexRange> ranges,
+                                        std::vector<IndexRange>& output);
+
+// Same with the edges of the triangles, 2 indices each. Both orientations of
+// an edge count as the same edge.
+std::vector<uint32_t> BuildLineIndices(std::span<const uint32_t> triangles, std::span<const IndexRange> ranges,
+                                       std::vector<IndexRange>& output);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "math/vector.hpp"
+#include <cstdint>
+
+// A level of detail of a model: a range of the index buffer drawing a
+// simplified version of the mesh with the same vertex buffer. Level 0 is the
+// full resolution mesh.
+struct MeshLod
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    // Geometric error of the level in model units, 0 for the full mesh.
+    float error;
+    // Range of the meshlets covering the level, empty when none were built.
+    uint32_t meshletOffset;
+    uint32_t meshletCount;
+};
+
+// A small cluster of triangles, contiguous in the index buffer, that can be
+// culled as a whole. Positions and directions are in model space.
+struct Meshlet
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+
+    // Sphere enclosing every vertex of the cluster.
+    Vector3 center;
+    float radius;
+
+    // Every triangle normal lies within the cone of this axis. The cluster only
+    // faces away from a viewer at `v` when
+    // dot(center - v, coneAxis) >= coneCutoff * length(center - v) + radius.
+    // A cutoff of 1 never culls.
+    Vector3 coneAxis;
+    float coneCutoff;
+};
+
+// A part of the model: the triangles that share an object or group name (o and
+// g lines) and a material (usemtl lines). Files without any of these lines have
+// a single unnamed part.
+struct Submesh
+{
+    // Ranges of the string table of the model, see Model::GetSubmeshName.
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t materialOffset;
+    uint32_t materialLength;
+
+    Vector3 boundsMin;
+    Vector3 boundsMax;
+};
+
+// The index range drawing one submesh at one level of detail, and the meshlets
+// covering it.
+struct MeshRange
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t meshletOffset;
+    uint32_t meshletCount;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Vertex welding run on a model after parsing. The parser only merges face
+// corners with the same v and vt indices, exporters that write the same
+// position several times leave one vertex per copy, and seams the GPU caches
+// cannot share.
+//
+// https://www.cs.ucdavis.edu/~amenta/s04/hash.pdf
+// https://matthias-research.github.io/pages/publications/tetraederCollision.pdf
+
+// Tolerances used by Model, relative to the largest side of the model bounds
+// for positions, absolute for texture coordinates.
+constexpr float WELD_POSITION_TOLERANCE = 1e-6f;
+constexpr float WELD_UV_TOLERANCE = 1e-6f;
+
+// Merge vertices whose positions are less than `positionEpsilon` apart, and
+// whose texture coordinates differ by less than `uvEpsilon` on both axes, into
+// the first of them. `vertices` holds a position and texture coordinates in its
+// first 5 floats every `stride` floats, and is compacted in place, keeping the
+// order of the remaining vertices. Indices are remapped in place. Return the
+// new vertex count.
+//
+// Positions are hashed in a grid of cells a few epsilons wide, so each vertex
+// only looks at the few cells its neighborhood overlaps and the pass stays
+// linear. `positionEpsilon` must be positive.
+std::size_t WeldVertices(std::vector<float>& vertices, std::size_t stride, std::span<uint32_t> indices,
+                         float positionEpsilon, float uvEpsilon);
+
+// Remove the triangles of `indices` that have two identical corners, keeping
+// the order of the others. Return the new index count.
+std::size_t RemoveDegenerateTriangles(std::span<uint32_t> indices);
@@ -1,20 +1,76 @@
 #pragma once
 
+#include "Material.hpp"
+#include "MeshCache.hpp"
+#include "MeshTypes.hpp"
+#include "ObjParser.hpp"
 #include "math/vector.hpp"
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
+// Levels of detail generated after the full mesh, each one keeping about half
+// the triangles of the previous one.
+constexpr uint32_t MAX_LOD_COUNT = 5;
+
+// Stop adding levels once simplification keeps more than this share of the
+// previous level, the rest of the mesh is locked on seams and borders.
+constexpr float MIN_LOD_REDUCTION = 0.9f;
+
+struct ModelLoadOptions
+{
+    // With a threadCount above 1, the file is split in line-aligned chunks
+    // parsed in parallel. The result is identical to the serial path.
+    uint32_t threadCount = 1;
+
+    // Read and write the binary sidecar described in MeshCache.hpp.
+    bool useCache = true;
+
+    // Merge vertices with nearly identical positions and texture coordinates,
+    // and drop the triangles they collapse, see MeshWelder.hpp.
+    bool weld = false;
+
+    // Reorder triangles and vertices for the GPU caches, see MeshOptimizer.hpp.
+    bool optimize = false;
+
+    // Append simplified levels of detail after the full mesh in the index
+    // buffer, see MeshSimplifier.hpp.
+    bool generateLods = false;
+
+    // Split every level in meshlets the renderer can cull on the CPU, see
+    // MeshClusterizer.hpp.
+    bool buildMeshlets = false;
+
+    // Build a bounding volume hierarchy over the full detail triangles, for
+    // picking, see MeshBvh.hpp. The Mesh keeps a copy of them and builds it on
+    // the first pick, on threadCount threads.
+    bool buildBvh = false;
+};
+
+// Parses an OBJ, or maps its mesh cache, and builds the buffers uploaded to the
+// GPU. A Model only lives until the upload, the renderer then keeps a Mesh.
 class Model
 {
     public:
-    Model(const std::string& filename);
-
-    void TriangulateFaces(const std::vector<std::string>& verticesString);
+    Model(const std::string& filename, const ModelLoadOptions& options = {});
 
-    void CreateFaces(const std::vector<std::string>& vertices);
+    void CreateFaces(const std::vector<FaceCorner>& corners);
+    // Resolve triangle corners against the vertices and texture coordinates
+    // parsed so far, and append them to the buffers. `uniqueVertices` must be
+    // the same table for every call on a model.
+    void AppendFaces(std::span<const FaceCorner> corners, VertexTable& uniqueVertices);
     void CalculateCentroid();
-    void CalculateTextureCoordinates();
+    void CalculateBounds();
+    // Ritter's approximate bounding sphere, a few percent larger than the
+    // smallest one: https://en.wikipedia.org/wiki/Bounding_sphere
+    void CalculateBoundingSphere();
+    void CalculateTextureCoordinates(std::size_t vertexCount);
 
+    // _vertices, _textureCoordinates and _textureIndices are only used while
+    // parsing and released once the vertex buffer is built.
     std::vector<Vector3> _vertices;
     std::vector<uint32_t> _verticesIndices;
 
@@ -23,8 +79,77 @@ class Model
 
     std::vector<float> _vertexBuffer;
 
-    std::unordered_map<std::string, uint32_t> _uniqueVertices;
-    std::vector<std::string> _triangleVertices;
-
     Vector3 _centroid;
-};
\ No newline at end of file
+    Vector3 _boundsMin;
+    Vector3 _boundsMax;
+    Vector3 _sphereCenter;
+    float _sphereRadius;
+
+    // Level 0 spans the whole mesh, the next ones are coarser.
+    std::vector<MeshLod> _lods;
+    std::vector<Meshlet> _meshlets;
+
+    // Level 0 of each submesh comes first, the ranges of level L are at
+    // L * _submeshes.size().
+    std::vector<Submesh> _submeshes;
+    std::vector<MeshRange> _submeshRanges;
+    std::string _submeshStrings;
+
+    // Loaded from the mtllib files next to the OBJ, on every load since they
+    // are not part of the mesh cache. Submeshes are sorted by material, and
+    // never share a vertex with a submesh of another material.
+    std::vector<std::string> _materialLibraries;
+    std::vector<Material> _materials;
+    std::vector<uint32_t> _submeshMaterials;
+
+    // Threads the Mesh builds its BVH on, 0 unless loaded with buildBvh.
+    uint32_t _bvhThreadCount;
+
+    // Interleaved positions and texture coordinates (5 floats per vertex) and
+    // triangle indices, either built by the parser or mapped from the cache.
+    std::span<const float> GetVertexData() const;
+    std::span<const uint32_t> GetIndexData() const;
+    std::span<const MeshLod> GetLods() const;
+    std::span<const Meshlet> GetMeshlets() const;
+
+    std::span<const Submesh> GetSubmeshes() const;
+    const MeshRange& GetSubmeshRange(std::size_t level, std::size_t submesh) const;
+    std::string_view GetSubmeshName(std::size_t submesh) const;
+    std::string_view GetSubmeshMaterial(std::size_t submesh) const;
+
+    std::span<const Material> GetMaterials() const;
+    // Index in GetMaterials, or NO_MATERIAL.
+    uint32_t GetSubmeshMaterialIndex(std::size_t submesh) const;
+
+    private:
+    friend class ModelStream;
+    friend class Mesh;
+
+    // Empty model filled by ModelStream.
+    Model();
+
+    static uint32_t GetCacheFlags(const ModelLoadOptions& options);
+    bool LoadCache(const std::string& filename, const MeshCacheKey& key, uint32_t flags);
+    // Everything done after parsing: bounds, optimization, levels of detail,
+    // meshlets and writing the cache.
+    void Finish(const std::string& filename, const ModelLoadOptions& options, const MeshCacheKey& key,
+                const std::vector<ObjRun>& runs);
+    // Everything not stored in the cache, done after parsing or loading it:
+    // materials, and whether the Mesh builds a bounding volume hierarchy.
+    void Complete(const std::string& filename, const ModelLoadOptions& options);
+
+    // Return the runs of the file, see ObjRun.
+    std::vector<ObjRun> Parse(const MappedFile& file, uint32_t threadCount);
+    // Gather the triangles of each submesh in one range of the index buffer.
+    void BuildSubmeshes(const std::vector<ObjRun>& runs);
+    void Weld(const std::string& filename);
+    void SplitVerticesByMaterial();
+    void LoadMaterials(const std::string& filename);
+    void CalculateSubmeshBounds();
+    void Optimize(const std::string& filename);
+    void GenerateLods(const std::string& filename, bool optimize);
+    void GenerateMeshlets(const std::string& filename);
+    std::vector<ObjRun> MergeChunks(std::vector<ObjChunk>& chunks);
+
+    std::unique_ptr<MeshCache> _cache;
+};
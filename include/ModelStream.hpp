@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Model.hpp"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bytes of the file parsed between two batches. Small enough for the first
+// triangles to reach the screen a few milliseconds after the load starts.
+constexpr std::size_t STREAM_BATCH_SIZE = 1024 * 1024;
+
+// Vertices and triangles parsed since the previous batch, in the layout of
+// Model::GetVertexData. Vertices go after the ones of the previous batches and
+// indices refer to everything streamed so far.
+struct MeshBatch
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+
+    // Of every vertex streamed so far.
+    Vector3 centroid;
+};
+
+// Load a model on a background thread and hand it over piece by piece, so the
+// renderer can draw what has been parsed while the rest of the file is read.
+// Once the whole file is parsed, the model goes through the same processing as
+// a blocking load (optimization, levels of detail, cache) and the finished
+// Model replaces the batches.
+class ModelStream
+{
+    public:
+    ModelStream(const std::string& filename, const ModelLoadOptions& options);
+    // Stop parsing at the next batch and wait for the thread.
+    ~ModelStream();
+
+    ModelStream(const ModelStream&) = delete;
+    ModelStream& operator=(const ModelStream&) = delete;
+
+    // Move the batches parsed since the last call to the end of `batches`.
+    // Rethrow the error that stopped the load, if any.
+    void Poll(std::vector<MeshBatch>& batches);
+
+    // The finished model, or nullptr while it is still being loaded. A model
+    // found in the mesh cache is returned without any batch.
+    std::unique_ptr<Model> TakeModel();
+
+    private:
+    void Load();
+    void Publish(Model& model, std::size_t& vertexCursor, std::size_t& indexCursor, Vector3& positionSum,
+                 std::size_t& positionCount);
+
+    std::string _filename;
+    ModelLoadOptions _options;
+
+    std::mutex _mutex;
+    std::vector<MeshBatch> _batches;
+    std::unique_ptr<Model> _model;
+    std::exception_ptr _error;
+
+    std::atomic<bool> _cancelled = false;
+    // Started last, once every other member is ready.
+    std::thread _thread;
+};
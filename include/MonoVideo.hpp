@@ -0,0 +1,140 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// Single-file container for black and white video, ex: Bad Apple. Each frame
+// is a plane of 1 bit per pixel, rows padded to whole bytes. Keyframes store
+// the plane, other frames its XOR with the previous one, which is zero
+// wherever nothing moved. Both are run length encoded, so a still frame takes
+// a few bytes. A seek decodes from the keyframe before it.
+//
+// Layout: MonoVideoHeader, frameCount MonoVideoFrame, keyframeCount uint32_t
+// frame numbers padded to 8 bytes, then the frames.
+constexpr char MONO_VIDEO_EXTENSION[] = ".mvid";
+
+// Bump whenever the layout of the file or the encoding of the frames changes.
+constexpr uint32_t MONO_VIDEO_VERSION = 1;
+
+// A keyframe at least this often bounds the deltas a seek decodes.
+constexpr uint32_t MONO_VIDEO_KEYFRAME_INTERVAL = 60;
+
+// Average of the color channels from which a pixel is white.
+constexpr int MONO_VIDEO_THRESHOLD = 128;
+
+struct MonoVideoHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameCount;
+    uint32_t frameRate;
+    uint32_t keyframeCount;
+    uint32_t reserved;
+};
+
+constexpr uint32_t MONO_VIDEO_KEYFRAME = 1u << 0;
+
+struct MonoVideoFrame
+{
+    // From the start of the file.
+    uint64_t offset;
+    uint32_t size;
+    uint32_t flags;
+};
+
+// Memory mapped reader. Throws when the file is missing or corrupt.
+class MonoVideo
+{
+    public:
+    explicit MonoVideo(const std::string& path);
+
+    MonoVideo(const MonoVideo&) = delete;
+    MonoVideo& operator=(const MonoVideo&) = delete;
+
+    // RGB rows of black and white pixels, in the order the frames were added.
+    // Callable from any thread, decodes are serialized. The frame after the
+    // last one decoded only applies its delta.
+    void DecodeFrame(uint32_t frame, unsigned char* pixels);
+
+    inline uint32_t GetWidth() const
+    {
+        return _header.width;
+    }
+
+    inline uint32_t GetHeight() const
+    {
+        return _header.height;
+    }
+
+    inline uint32_t GetFrameCount() const
+    {
+        return _header.frameCount;
+    }
+
+    inline uint32_t GetFrameRate() const
+    {
+        return _header.frameRate;
+    }
+
+    // Frames whose deltas were applied since the start, seeks included.
+    inline uint64_t GetDecodedCount() const
+    {
+        return _decodedCount;
+    }
+
+    private:
+    void ApplyFrame(uint32_t frame);
+
+    MappedFile _file;
+    MonoVideoHeader _header;
+    std::span<const MonoVideoFrame> _frames;
+    std::span<const uint32_t> _keyframes;
+
+    std::mutex _mutex;
+    std::vector<unsigned char> _plane;
+    // In _plane, none until the first decode.
+    uint32_t _planeFrame;
+    uint64_t _decodedCount = 0;
+};
+
+// Builds a container in memory, frame after frame.
+class MonoVideoWriter
+{
+    public:
+    MonoVideoWriter(uint32_t width, uint32_t height, uint32_t frameRate);
+
+    // RGB or RGBA rows, 3 or 4 channels, of the size given to the constructor.
+    void AddFrame(const unsigned char* pixels, int channels);
+
+    // Written to a temporary file renamed at the end. Throws on failure.
+    void Write(const std::string& path) const;
+
+    inline uint32_t GetKeyframeCount() const
+    {
+        return static_cast<uint32_t>(_keyframes.size());
+    }
+
+    inline std::size_t GetPayloadSize() const
+    {
+        return _payload.size();
+    }
+
+    private:
+    uint32_t _width;
+    uint32_t _height;
+    uint32_t _frameRate;
+    std::vector<unsigned char> _previous;
+    std::vector<MonoVideoFrame> _frames;
+    std::vector<uint32_t> _keyframes;
+    // Frames, offsets in _frames are relative to its start until Write.
+    std::vector<unsigned char> _payload;
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "math/vector.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Text level OBJ parsing shared by Model and ModelStream.
+
+// Marks a face corner written without texture coordinate, ex: "f 1 2 3" or "f 1//1 2//2 3//3".
+constexpr uint32_t NO_TEXTURE_INDEX = std::numeric_limits<uint32_t>::max();
+
+// Files are not split in chunks smaller than this when parsed in parallel.
+constexpr std::size_t MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// One corner of a face line, ex: "f 1/2 3/4 5/6" holds three corners.
+// Indices are zero based and global to the file.
+struct FaceCorner
+{
+    uint32_t vertexIndex;
+    uint32_t textureIndex;
+};
+
+// From `firstTriangle` on, triangles belong to this object or group and use this
+// material, as set by the o, g and usemtl lines. An empty optional keeps the
+// value of the previous run, which may come from a previous chunk.
+struct ObjRun
+{
+    uint32_t firstTriangle;
+    std::optional<std::string> name;
+    std::optional<std::string> material;
+};
+
+// Everything parsed from a line-aligned byte range of the file. Face corners
+// already hold global indices, so chunks only need to be concatenated in order.
+struct ObjChunk
+{
+    std::vector<Vector3> vertices;
+    std::vector<Vector2> textureCoordinates;
+    std::vector<FaceCorner> triangles;
+    std::vector<FaceCorner> faceCorners;
+
+    // Sorted by triangle, relative to the first triangle of the chunk.
+    std::vector<ObjRun> runs;
+    // File names of the mtllib lines, as written.
+    std::vector<std::string> materialLibraries;
+
+    // Number of v and vt lines seen before the first face line of the chunk.
+    bool hasFace = false;
+    std::size_t firstFaceVertexCount = 0;
+    std::size_t firstFaceTextureCount = 0;
+};
+
+// Append the triangles of a face of `count` corners, at least 3.
+void TriangulateFaces(const FaceCorner* corners, std::size_t count, std::vector<FaceCorner>& triangles);
+
+// Parse every line of [it, end), which must start at the beginning of a line.
+void ParseObjChunk(const char* it, const char* end, ObjChunk& chunk);
+
+// Resolve the runs of consecutive chunks, with every name and material set and
+// triangles counted from the first chunk. `name` and `material` hold the state
+// before the first chunk and receive the state after the last one. Runs that
+// end up without triangles are dropped.
+std::vector<ObjRun> ResolveObjRuns(std::span<const ObjChunk> chunks, std::string& name, std::string& material);
+
+// Split [begin, end) in `count` ranges that all start at the beginning of a line.
+std::vector<const char*> SplitObjInLines(const char* begin, const char* end, std::size_t count);
+
+// Open-addressing hash table from a packed (vertex, texture) key to the index
+// of the unique vertex in the vertex buffer. Keys and values live in two flat
+// arrays and collisions are resolved by linear probing, so a lookup touches one
+// or two cache lines and nothing is allocated per corner.
+class VertexTable
+{
+    public:
+    // In a closed mesh there is about one unique vertex for two triangles, one
+    // slot per triangle keeps the table around half full and probes short.
+    explicit VertexTable(std::size_t triangleCount) : _size(0)
+    {
+        Allocate(std::max<std::size_t>(std::bit_ceil(triangleCount), 16));
+    }
+
+    // Return the value stored for `key`, or store `value` if the key is new.
+    // The boolean tells whether the value was inserted.
+    std::pair<uint32_t, bool> Insert(uint64_t key, uint32_t value)
+    {
+        std::size_t slot = Hash(key) & _mask;
+
+        while (_keys[slot] != EMPTY_KEY)
+        {
+            if (_keys[slot] == key)
+            {
+                return {_values[slot], false};
+            }
+            slot = (slot + 1) & _mask;
+        }
+
+        _keys[slot] = key;
+        _values[slot] = value;
+
+        // Keep the load factor under 3/4, meshes with many seams can have more
+        // unique vertices than the estimate.
+        if (++_size * 4 > _keys.size() * 3)
+        {
+            Grow();
+        }
+        return {value, true};
+    }
+
+    // Return the value stored for `key`, or NOT_FOUND.
+    uint32_t Find(uint64_t key) const
+    {
+        std::size_t slot = Hash(key) & _mask;
+
+        while (_keys[slot] != EMPTY_KEY)
+        {
+            if (_keys[slot] == key)
+            {
+                return _values[slot];
+            }
+            slot = (slot + 1) & _mask;
+        }
+        return NOT_FOUND;
+    }
+
+    static constexpr uint32_t NOT_FOUND = std::numeric_limits<uint32_t>::max();
+
+    private:
+    // A face corner always references an existing texture coordinate, so its low
+    // half can never be all ones.
+    static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+
+    // https://xorshift.di.unimi.it/splitmix64.c finalizer, consecutive indices
+    // end up far apart.
+    static inline uint64_t Hash(uint64_t key)
+    {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return key;
+    }
+
+    void Allocate(std::size_t capacity)
+    {
+        _keys.assign(capacity, EMPTY_KEY);
+        _values.resize(capacity);
+        _mask = capacity - 1;
+    }
+
+    void Grow()
+    {
+        const std::vector<uint64_t> keys = std::move(_keys);
+        const std::vector<uint32_t> values = std::move(_values);
+
+        Allocate(keys.size() * 2);
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            if (keys[i] != EMPTY_KEY)
+            {
+                std::size_t slot = Hash(keys[i]) & _mask;
+                while (_keys[slot] != EMPTY_KEY)
+                {
+                    slot = (slot + 1) & _mask;
+                }
+                _keys[slot] = keys[i];
+                _values[slot] = values[i];
+            }
+        }
+    }
+
+    std::vector<uint64_t> _keys;
+    std::vector<uint32_t> _values;
+    std::size_t _mask;
+    std::size_t _size;
+};
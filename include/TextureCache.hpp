@@ -0,0 +1,74 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "TextureCompression.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Binary sidecar written next to a TGA after its first load, ex:
+// "earth.tga" -> "earth.tga.bccache". It holds every level of the block
+// compressed mip chain, so later loads skip decoding, filtering and encoding
+// and hand the mapped pages straight to the GPU.
+constexpr char TEXTURE_CACHE_EXTENSION[] = ".bccache";
+
+// Bump whenever the layout of the file or the output of the encoder changes.
+constexpr uint32_t TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    // The source TGA, identified like the OBJ of a mesh cache.
+    MeshCacheKey key;
+
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint64_t payloadSize;
+};
+
+class TextureCache
+{
+    public:
+    static std::string GetCachePath(const std::string& sourcePath);
+
+    // Map the cache of `sourcePath`. Return nullptr if there is none, or if it is
+    // stale or corrupt, in which case the caller should decode the source.
+    static std::unique_ptr<TextureCache> Open(const std::string& sourcePath, const MeshCacheKey& key);
+
+    // Failing to write is not an error, the next load simply compresses the
+    // source again.
+    static bool Write(const std::string& sourcePath, const MeshCacheKey& key, BlockFormat format, uint32_t width,
+                      uint32_t height, std::span<const unsigned char> blocks);
+
+    std::span<const unsigned char> GetBlocks() const;
+
+    inline BlockFormat GetFormat() const
+    {
+        return static_cast<BlockFormat>(_header.format);
+    }
+
+    inline const std::vector<MipLevel>& GetLevels() const
+    {
+        return _levels;
+    }
+
+    inline const TextureCacheHeader& GetHeader() const
+    {
+        return _header;
+    }
+
+    private:
+    TextureCache(std::unique_ptr<MappedFile> file, const TextureCacheHeader& header);
+
+    std::unique_ptr<MappedFile> _file;
+    TextureCacheHeader _header;
+    std::vector<MipLevel> _levels;
+};
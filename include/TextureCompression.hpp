@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ImageMipmap.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Block compression, the GPU samples 4x4 texel blocks of a fixed size
+// directly, without ever expanding them in memory:
+// - BC1 holds RGB in 8 bytes, 1/8 of RGBA8.
+// - BC3 adds an 8 byte alpha block, 1/4 of RGBA8.
+// - BC4 holds one channel in 8 bytes, used for gray textures.
+// https://learn.microsoft.com/en-us/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression
+
+// The values are stored in texture caches, do not renumber them.
+enum class BlockFormat : uint32_t
+{
+    BC1 = 1,
+    BC3 = 3,
+    BC4 = 4,
+};
+
+const char* GetBlockFormatName(BlockFormat format);
+std::size_t GetBlockSize(BlockFormat format);
+
+// The levels of GetMipLevels, with offsets in compressed bytes. Levels smaller
+// than a block still take a whole one.
+std::vector<MipLevel> GetCompressedLevels(uint32_t width, uint32_t height, BlockFormat format);
+std::size_t GetCompressedSize(std::span<const MipLevel> levels, BlockFormat format);
+
+// The smallest format that keeps what the pixels hold: BC4 when every pixel is
+// gray and opaque, BC1 when they are opaque, BC3 otherwise.
+BlockFormat ChooseBlockFormat(const unsigned char* pixels, std::size_t pixelCount, int channels);
+
+// Compress RGB or RGBA rows, 3 or 4 channels. Rows of blocks are split among
+// up to `threadCount` threads. Blocks past the edge repeat the last row and
+// column.
+void CompressImage(const unsigned char* pixels, uint32_t width, uint32_t height, int channels, BlockFormat format,
+                   unsigned char* blocks, unsigned int threadCount);
+
+// Every level of a chain laid out by GetMipLevels, to the layout of
+// GetCompressedLevels.
+std::vector<unsigned char> CompressMipChain(const unsigned char* chain, std::span<const MipLevel> levels, int channels,
+                                            BlockFormat format, unsigned int threadCount);
+
+// Back to RGBA rows, as the GPU would sample them.
+void DecompressImage(const unsigned char* blocks, uint32_t width, uint32_t height, BlockFormat format,
+                     unsigned char* pixels);
+
+// Peak signal to noise ratio in dB of `decoded`, RGBA, against `original`,
+// over the channels of the original. Infinite when they are identical.
+double ComputePSNR(const unsigned char* original, int channels, const unsigned char* decoded, std::size_t pixelCount);
@@ -2,12 +2,18 @@
 
 #include "AudioPlayer.hpp"
 #include "Model.hpp"
+#include "ModelStream.hpp"
 #include "Window.hpp"
+#include "app/FrameTimeHistogram.hpp"
 #include "camera.hpp"
 #include "renderer/IRenderer.hpp"
+#include <filesystem>
 #include <memory>
+#include <thread>
 
-constexpr double BAD_APPLE_FPS = 30.0;
+// OBJ files from this size are loaded in the background and drawn while they
+// load, smaller ones load before the window shows anything.
+constexpr std::uintmax_t STREAMING_MIN_FILE_SIZE = 64 * 1024 * 1024;
 
 class Model;
 
@@ -20,10 +26,34 @@ class Application
 
     void Run();
     void ProcessInput() {};
+    void PrintRenderStats() const;
+    void SelectNextSubmesh();
+    void ToggleSelectedSubmesh();
+    void PickModel(float x, float y) const;
+    void TogglePlayback();
 
-    inline void LoadModel(const std::string& path)
+    // Must be called before Run.
+    inline void SetVertexFormat(VertexFormat format)
     {
-        _renderer->LoadModel(std::make_unique<Model>(path));
+        _renderer->SetVertexFormat(format);
+    }
+
+    // `options` holds the optional stages asked for on the command line.
+    inline void LoadModel(const std::string& path, ModelLoadOptions options)
+    {
+        // Parse the OBJ on every core, the output is the same as a serial load.
+        options.threadCount = std::thread::hardware_concurrency();
+        // Clicks pick triangles.
+        options.buildBvh = true;
+
+        std::error_code error;
+        if (std::filesystem::file_size(path, error) >= STREAMING_MIN_FILE_SIZE && !error)
+        {
+            _renderer->StreamModel(std::make_unique<ModelStream>(path, options));
+            return;
+        }
+
+        _renderer->LoadModel(std::make_unique<Model>(path, options));
     }
 
     inline void LoadTexture(const std::string& path)
@@ -43,6 +73,11 @@ class Application
     std::unique_ptr<IRenderer> _renderer;
     std::unique_ptr<AudioPlayer> _audioPlayer;
     Camera _camera;
+    FrameTimeHistogram _frameTimes;
+
+    size_t _selectedSubmesh = 0;
 
     bool _isRunning = true;
+    // Bad Apple and its music, which keeps time when it plays.
+    bool _isPlaying = false;
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Upper bounds of the buckets in milliseconds, the last one takes the rest.
+// 16.7 and 33.3 are one and two refreshes at 60 Hz, so a hitch shows as frames
+// moving past them.
+constexpr std::array<double, 7> FRAME_TIME_BUCKETS = {4.0, 8.0, 12.0, 16.7, 20.0, 33.3, 50.0};
+
+// Distribution of frame times since the last Reset.
+class FrameTimeHistogram
+{
+    public:
+    void Add(double seconds);
+    void Reset();
+    void Print(std::ostream& out) const;
+
+    private:
+    std::array<uint32_t, FRAME_TIME_BUCKETS.size() + 1> _counts = {};
+    uint32_t _frameCount = 0;
+    double _totalTime = 0.0;
+    double _maxTime = 0.0;
+};
@@ -39,6 +39,14 @@ struct Matrix4 {
         return m;
     }
 
+    static Matrix4 scale(const Vector3 &v) {
+        Matrix4 m(1.0);
+        m._m[0][0] = v.x;
+        m._m[1][1] = v.y;
+        m._m[2][2] = v.z;
+        return m;
+    }
+
     // https://www.geeksforgeeks.org/rotation-matrix/#3d-rotation-matrix
 
     static Matrix4 rotationX(float angle) {
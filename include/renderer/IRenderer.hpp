@@ -1,7 +1,9 @@
 #pragma once
 
 #include "ITexture.hpp"
+#include "MeshBvh.hpp"
 #include "camera.hpp"
+#include <string_view>
 
 enum class RotationAxis
 {
@@ -18,8 +20,68 @@ enum class RenderMode
     FILL
 };
 
+// How vertices are stored on the GPU. Quantized formats store positions
+// relative to the model bounds and decode them in the model matrix.
+enum class VertexFormat
+{
+    // 3 float positions, 2 float texture coordinates: 20 bytes.
+    FLOAT,
+    // 4 half float positions, 2 normalized 16-bit (or half float) texture coordinates: 12 bytes.
+    HALF_FLOAT,
+    // 4 normalized 16-bit positions, 2 normalized 16-bit (or half float) texture coordinates: 12 bytes.
+    UNORM16
+};
+
+// Work done by the last rendered frame.
+struct RenderStats
+{
+    uint32_t clustersTested = 0;
+    // Rejected because they face away from the camera, or lie outside the frustum.
+    uint32_t clustersBackfacing = 0;
+    uint32_t clustersOutside = 0;
+    // Contiguous index ranges submitted for the model, adjacent visible
+    // clusters share one.
+    uint32_t drawRanges = 0;
+    uint32_t trianglesDrawn = 0;
+    // Points, lines or triangles submitted for those triangles, depending on
+    // the render mode.
+    uint32_t primitivesDrawn = 0;
+    // Submeshes with at least one triangle drawn, and the ones hidden or
+    // entirely culled.
+    uint32_t partsDrawn = 0;
+    uint32_t partsSkipped = 0;
+    // Texture binds and draw calls of the whole frame, background included.
+    uint32_t textureBinds = 0;
+    uint32_t drawCalls = 0;
+    // Storage of the textures against its budget, and how many were evicted
+    // or reloaded since the start.
+    uint64_t textureBytes = 0;
+    uint64_t textureBudget = 0;
+    uint64_t textureEvictions = 0;
+    uint64_t textureReloads = 0;
+    // Bad Apple frames loaded ahead of time, loaded only once due, and loads
+    // cancelled by a seek or a pause, since the start.
+    uint64_t framesPrefetched = 0;
+    uint64_t frameDemandLoads = 0;
+    uint64_t frameLoadsCancelled = 0;
+    // Bad Apple frames never shown, shown after they were due, and rendered
+    // frames repeating an older one, see MediaScheduler.
+    uint64_t framesDropped = 0;
+    uint64_t framesLate = 0;
+    uint64_t framesRepeated = 0;
+    bool audioClock = false;
+};
+
+// Point of the model under a pixel of the window.
+struct PickResult
+{
+    RayHit hit;
+    size_t submesh;
+};
+
 class ITexture;
 class Model;
+class ModelStream;
 
 class IRenderer
 {
@@ -33,14 +95,38 @@ class IRenderer
 
     virtual void SetRotationAxis(RotationAxis) = 0;
     virtual void SetPolygonMode(RenderMode) = 0;
+    // Must be called before Start.
+    virtual void SetVertexFormat(VertexFormat) = 0;
     virtual void ApplyTexture() = 0;
     virtual void PlayBadApple() = 0;
     virtual void ApplyDissolve() = 0;
 
-    virtual void SetFrame(size_t frame) = 0;
+    // The Bad Apple frames follow the audio position given before each
+    // Update, and time measured by Update when none is. While paused the frame
+    // stays, and no later frame is prefetched.
+    virtual void SetAudioTime(double seconds) = 0;
+    virtual void SetPlaying(bool playing) = 0;
+
+    virtual const RenderStats& GetRenderStats() const = 0;
+
+    // Parts of the model split by its `o`, `g` and `usemtl` lines, empty until
+    // the model is uploaded.
+    virtual size_t GetSubmeshCount() const = 0;
+    virtual std::string_view GetSubmeshName(size_t submesh) const = 0;
+    virtual bool IsSubmeshVisible(size_t submesh) const = 0;
+    virtual void SetSubmeshVisible(size_t submesh, bool visible) = 0;
+
+    // Cast a ray through the pixel (x, y) of the window, hidden parts included.
+    // Return false if it misses the model, or if the model has no BVH. The
+    // first pick builds the BVH.
+    virtual bool Pick(float x, float y, PickResult& result) const = 0;
 
     virtual void SwapBuffers() = 0;
     virtual void LoadModel(std::unique_ptr<Model>) = 0;
+    // Draw the model while it loads, in place of LoadModel.
+    virtual void StreamModel(std::unique_ptr<ModelStream>) = 0;
+    // Until the streamed model replaces its batches.
+    virtual bool IsStreaming() const = 0;
     virtual void LoadTexture(std::unique_ptr<ITexture>) = 0;
     virtual void LoadNoiseTexture(std::unique_ptr<ITexture>) = 0;
 
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ITexture.hpp"
+#include "MonoVideo.hpp"
+#include "TextureLoader.hpp"
+#include "TextureOpenGL.hpp"
+#include "TextureResidency.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+// Frames after the current one kept loaded or loading during playback, 266 ms
+// at 30 frames per second.
+constexpr std::size_t FRAME_PREFETCH_WINDOW = 8;
+
+// Textures the frames are played through: the window, the current frame, and
+// the last ready frame, which stays on screen until the current one is ready.
+constexpr std::size_t FRAME_POOL_SIZE = FRAME_PREFETCH_WINDOW + 2;
+
+// Keeps the frames of a video about to be shown decoded ahead of time, on the
+// workers of a TextureLoader, into a pool of reused textures. The frames after
+// the last one wrap to the first. Loads of frames that leave the window, after
+// a seek, or that are not needed yet when playback pauses, are cancelled.
+class FramePrefetcher
+{
+    public:
+    // With no video, every frame is black.
+    FramePrefetcher(TextureLoader& loader, TextureResidency& residency, std::shared_ptr<MonoVideo> video);
+
+    FramePrefetcher(const FramePrefetcher&) = delete;
+    FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+
+    // Once per frame on the GL thread, with the frame to show. While paused
+    // only that frame is loaded.
+    void Update(std::size_t currentFrame, bool playing);
+
+    // The current frame once ready, the last ready one until then.
+    const ITexture& GetShownFrame();
+    // Of that texture, NO_FRAME for a placeholder.
+    inline std::size_t GetShownFrameNumber() const
+    {
+        return _slots[_shownSlot].frame;
+    }
+
+    // Since the start: frames loaded ahead of time, frames only loaded once
+    // already due, and loads cancelled before being uploaded. Only the first
+    // frame and those right after a seek should be loaded on demand.
+    inline uint64_t GetPrefetchCount() const
+    {
+        return _prefetchCount;
+    }
+
+    inline uint64_t GetDemandLoadCount() const
+    {
+        return _demandLoadCount;
+    }
+
+    inline uint64_t GetCancelCount() const
+    {
+        return _cancelCount;
+    }
+
+    static constexpr std::size_t NO_FRAME = std::numeric_limits<std::size_t>::max();
+
+    private:
+    struct FrameSlot
+    {
+        std::shared_ptr<TextureOpenGL> texture;
+        std::size_t frame = NO_FRAME;
+    };
+
+    // Frames ahead of `frame`, wrapping after the last one.
+    std::size_t GetDistance(std::size_t frame) const;
+    FrameSlot* FindSlot(std::size_t frame);
+    void Load(std::size_t frame, bool due);
+
+    TextureLoader& _loader;
+    TextureResidency& _residency;
+    std::shared_ptr<MonoVideo> _video;
+    std::array<FrameSlot, FRAME_POOL_SIZE> _slots;
+    std::size_t _currentFrame = 0;
+    std::size_t _shownSlot = 0;
+
+    uint64_t _prefetchCount = 0;
+    uint64_t _demandLoadCount = 0;
+    uint64_t _cancelCount = 0;
+};
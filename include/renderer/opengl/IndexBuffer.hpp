@@ -11,21 +11,39 @@
 // Index Buffer, we would store the same vertex multiple times in the buffer,
 // which is less efficient in terms of memory usage.
 
+//
+// Meshes with fewer than 65536 vertices can use 16-bit indices, which halves
+// the size of the buffer and the index fetch bandwidth.
+
+#include <cstdint>
+#include <vector>
+
 class IndexBuffer {
     public:
     // Generate an GL_ELEMENT_ARRAY_BUFFER, bind it and setting it to
     // GL_STATIC_DRAW.
     IndexBuffer(const unsigned int *data, unsigned int count);
+    IndexBuffer(const uint16_t *data, unsigned int count);
     ~IndexBuffer();
 
     void Bind() const;
     void Unbind() const;
 
+    // Copy the indices back from the GPU, widened to 32 bits. Slow, for
+    // building derived buffers once.
+    std::vector<uint32_t> Read() const;
+
     inline unsigned int getCount() const {
         return _count;
     }
 
+    // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT, to pass to glDrawElements.
+    inline unsigned int getType() const {
+        return _type;
+    }
+
     private:
     unsigned int _rendererId;
     unsigned int _count;
+    unsigned int _type;
 };
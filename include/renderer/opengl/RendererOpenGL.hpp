@@ -7,22 +7,41 @@
 #include <memory>
 
 #include "ITexture.hpp"
+#include "MediaScheduler.hpp"
+#include "Mesh.hpp"
+#include "MonoVideo.hpp"
+#include "MeshTopology.hpp"
 #include "Model.hpp"
+#include "ModelStream.hpp"
 #include "Window.hpp"
 #include "camera.hpp"
 #include "math/Matrix4.hpp"
 #include "renderer/IRenderer.hpp"
 
+#include "FramePrefetcher.hpp"
 #include "IndexBuffer.hpp"
 #include "ShaderOpenGL.hpp"
+#include "TextureArrayOpenGL.hpp"
+#include "TextureLoader.hpp"
 #include "TextureOpenGL.hpp"
+#include "TextureResidency.hpp"
 #include "VertexBuffer.hpp"
+#include "StreamBuffer.hpp"
+#include "VertexBufferLayout.hpp"
 #include <vector>
 
 constexpr float CAMERA_SPEED = 10.0f;
 constexpr float ROTATION_SPEED = 0.5f;
 constexpr float BLEND_SPEED = 0.02f;
-constexpr float FRAME_TIME = 1.0f / 30.0f;
+
+// Coarsest level of detail drawn is the one whose geometric error stays under
+// this many pixels on screen.
+constexpr float LOD_PIXEL_ERROR = 1.0f;
+constexpr float NEAR_PLANE = 0.1f;
+constexpr float FAR_PLANE = 1000.0f;
+
+// Initial size of the buffers receiving a streamed model, they double when full.
+constexpr std::size_t STREAM_BUFFER_CAPACITY = 16 * 1024 * 1024;
 
 // Ensure that if there is any GL error, it close the program and tell which GL
 // error code happened. #x -> transform into a string. For development purpose.
@@ -60,6 +79,11 @@ class RendererOpenGL : public IRenderer
 
     void SetPolygonMode(RenderMode mode) override;
 
+    inline void SetVertexFormat(VertexFormat format) override
+    {
+        _vertexFormat = format;
+    }
+
     inline void SetRotationAxis(RotationAxis axis) override
     {
         _activeAxis = axis;
@@ -67,18 +91,59 @@ class RendererOpenGL : public IRenderer
 
     void SwapBuffers() override;
 
+    inline const RenderStats& GetRenderStats() const override
+    {
+        return _stats;
+    }
+
+    inline size_t GetSubmeshCount() const override
+    {
+        return _submeshVisible.size();
+    }
+
+    inline std::string_view GetSubmeshName(size_t submesh) const override
+    {
+        return _mesh->GetSubmeshName(submesh);
+    }
+
+    inline bool IsSubmeshVisible(size_t submesh) const override
+    {
+        return _submeshVisible[submesh];
+    }
+
+    inline void SetSubmeshVisible(size_t submesh, bool visible) override
+    {
+        _submeshVisible[submesh] = visible;
+    }
+
+    bool Pick(float x, float y, PickResult& result) const override;
+
     inline void LoadModel(std::unique_ptr<Model> model) override
     {
         _model = std::move(model);
     }
 
+    inline void StreamModel(std::unique_ptr<ModelStream> stream) override
+    {
+        _stream = std::move(stream);
+    }
+
+    inline bool IsStreaming() const override
+    {
+        return _stream != nullptr;
+    }
+
+    // Both are bound every frame or may be at any moment, they are never
+    // evicted.
     inline void LoadTexture(std::unique_ptr<ITexture> texture) override
     {
+        _textureResidency.SetPinned(*texture, true);
         _texture = std::move(texture);
     }
 
     inline void LoadNoiseTexture(std::unique_ptr<ITexture> texture) override
     {
+        _textureResidency.SetPinned(*texture, true);
         _noiseTexture = std::move(texture);
     }
 
@@ -108,17 +173,19 @@ class RendererOpenGL : public IRenderer
 
     inline std::unique_ptr<ITexture> CreateTexture(const std::string& path) override
     {
-        return std::make_unique<TextureOpenGL>(path);
+        std::unique_ptr<TextureOpenGL> texture = std::make_unique<TextureOpenGL>(path);
+        _textureResidency.Add(*texture);
+        return texture;
     }
 
-    virtual void SetFrame(size_t frame) override
+    inline void SetAudioTime(double seconds) override
     {
-        if (frame >= _badAppleFrames.size())
-        {
-            frame = _badAppleFrames.size() - 1;
-        }
-        _currentFrame = frame;
-        LoadFrameIfNeeded(_currentFrame);
+        _mediaScheduler->SetAudioTime(seconds);
+    }
+
+    inline void SetPlaying(bool playing) override
+    {
+        _mediaScheduler->SetPlaying(playing);
     }
 
     Matrix4 GetFinalMatrix(RotationAxis activeAxis, const Matrix4& accumulatedRotationMatrix);
@@ -131,8 +198,20 @@ class RendererOpenGL : public IRenderer
     Matrix4 _accumulatedRotationMatrix = Matrix4(1.0f);
     Matrix4 _viewMatrix;
     Matrix4 _projectionMatrix;
+    // Turns quantized positions back into model space, identity for float ones.
+    Matrix4 _positionDecode = Matrix4(1.0f);
+
+    RenderStats _stats;
+
+    // Index ranges of the visible submeshes and meshlets, rebuilt every frame.
+    std::vector<GLsizei> _drawCounts;
+    std::vector<const void*> _drawOffsets;
+
+    std::vector<bool> _submeshVisible;
 
     RotationAxis _activeAxis = RotationAxis::NONE;
+    RenderMode _renderMode = RenderMode::FILL;
+    VertexFormat _vertexFormat = VertexFormat::FLOAT;
 
     Window& _window;
 
@@ -142,20 +221,51 @@ class RendererOpenGL : public IRenderer
     std::unique_ptr<IndexBuffer> _ib;
     std::unique_ptr<IndexBuffer> _quadIB;
 
+    // Unique vertices and edges of the model for the point and line modes,
+    // built the first time each mode is used. Ranges are indexed by cluster,
+    // see AddCluster.
+    std::unique_ptr<IndexBuffer> _pointIB;
+    std::unique_ptr<IndexBuffer> _lineIB;
+    std::vector<IndexRange> _pointRanges;
+    std::vector<IndexRange> _lineRanges;
+
     std::unique_ptr<ShaderOpenGL> _shader;
     std::unique_ptr<ShaderOpenGL> _quadShader;
 
+    // Declared before every texture, which unregister from it when destroyed.
+    TextureResidency _textureResidency;
+
     std::unique_ptr<ITexture> _texture;
     std::unique_ptr<ITexture> _noiseTexture;
-    std::vector<std::unique_ptr<ITexture>> _badAppleFrames;
-
+    std::unique_ptr<TextureLoader> _textureLoader;
+    // Shared with the decodes in flight. Null when the video is missing, the
+    // frames then stay black.
+    std::shared_ptr<MonoVideo> _badAppleVideo;
+    // Picks the Bad Apple frame due, the prefetcher loads it and the next ones
+    // in the background.
+    std::unique_ptr<MediaScheduler> _mediaScheduler;
+    std::unique_ptr<FramePrefetcher> _framePrefetcher;
+
+    // Waiting for Start, released once uploaded.
     std::unique_ptr<Model> _model;
+    std::unique_ptr<Mesh> _mesh;
+
+    // Set when the model has materials: every material in one texture array,
+    // and the layer of each vertex as a separate attribute.
+    std::unique_ptr<TextureArrayOpenGL> _materialTextures;
+    std::unique_ptr<VertexBuffer> _layerVB;
+
+    // While a streamed model loads, the batches received so far are drawn from
+    // these buffers. They are released once the finished model is uploaded.
+    std::unique_ptr<ModelStream> _stream;
+    std::unique_ptr<StreamBuffer> _streamVB;
+    std::unique_ptr<StreamBuffer> _streamIB;
+    std::vector<MeshBatch> _streamBatches;
+    uint32_t _streamIndexCount = 0;
 
     uint32_t _VAO = 0;
     uint32_t _quadVAO = 0;
-    uint32_t _currentFrame = 0;
 
-    float _frameTimer = 0.0f;
     float _dissolveAmount = 0.0f;
     float _blendFactor = 0.0f;
     float _targetBlendFactor = 0.0f;
@@ -164,5 +274,16 @@ class RendererOpenGL : public IRenderer
     bool _useDissolve = false;
     bool _transitioning = false;
 
-    void LoadFrameIfNeeded(std::size_t frameIndex);
+    void UploadModel(std::unique_ptr<Model> model);
+    void UploadMaterials(const Model& model);
+    void PollStream();
+    void SetModelCenter(const Vector3& center);
+    const MeshLod& SelectLod() const;
+    bool IsSphereInFrustum(const Vector3& viewCenter, float radius) const;
+    void ApplyRenderMode();
+    void BuildTopology();
+    void AddDrawRange(uint32_t indexOffset, uint32_t indexCount);
+    void AddCluster(std::size_t cluster, uint32_t indexOffset, uint32_t indexCount);
+    void CullSubmeshes(std::size_t level, const Matrix4& modelViewMatrix);
+    void CullMeshlets(const MeshRange& range, const Matrix4& modelViewMatrix);
 };
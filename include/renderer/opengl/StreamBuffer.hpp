@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+// A buffer object that data can be appended to, used to upload a model while it
+// is still being parsed. When full, a buffer twice as large replaces it and the
+// content is copied on the GPU with glCopyBufferSubData, nothing goes back to
+// the CPU.
+class StreamBuffer {
+    public:
+    // `target` is the binding used by Bind, ex: GL_ARRAY_BUFFER.
+    StreamBuffer(unsigned int target, std::size_t capacity);
+    ~StreamBuffer();
+
+    // Return true when the buffer object was replaced, it must then be bound
+    // again wherever the old one was, ex: vertex attributes of a VAO.
+    bool Append(const void *data, std::size_t size);
+
+    void Bind() const;
+
+    inline std::size_t getSize() const {
+        return _size;
+    }
+
+    private:
+    unsigned int _rendererId;
+    unsigned int _target;
+    std::size_t _size;
+    std::size_t _capacity;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ITexture.hpp"
+#include "Material.hpp"
+#include <cstdint>
+#include <span>
+
+// Layers are never larger than this, bigger diffuse maps are scaled down.
+constexpr uint32_t MATERIAL_LAYER_MAX_SIZE = 1024;
+
+// The materials of a model in one GL_TEXTURE_2D_ARRAY, so a model with many
+// materials is drawn with a single texture bind. Layer i holds the diffuse map
+// of material i, or its diffuse color without one. The last layer is white,
+// for submeshes without a material.
+class TextureArrayOpenGL : public ITexture
+{
+    public:
+    TextureArrayOpenGL(std::span<const Material> materials);
+    ~TextureArrayOpenGL();
+
+    TextureArrayOpenGL(const TextureArrayOpenGL&) = delete;
+    TextureArrayOpenGL& operator=(const TextureArrayOpenGL&) = delete;
+
+    void Bind(unsigned int slot = 0) const override;
+
+    virtual inline uint32_t GetWidth() const override
+    {
+        return _width;
+    }
+
+    virtual inline uint32_t GetHeight() const override
+    {
+        return _height;
+    }
+
+    // Layer of a material index, NO_MATERIAL or materials past the layer limit
+    // of the driver use the white layer.
+    inline uint32_t GetLayer(uint32_t material) const
+    {
+        return material < _layerCount - 1 ? material : _layerCount - 1;
+    }
+
+    inline uint32_t GetLayerCount() const
+    {
+        return _layerCount;
+    }
+
+    private:
+    unsigned int _rendererID;
+    uint32_t _width;
+    uint32_t _height;
+    uint32_t _layerCount;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "ImageTGA.hpp"
+#include "MappedFile.hpp"
+#include "TextureOpenGL.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Time the GL thread spends per frame on loads: mapping buffers, starting
+// decodes and finishing uploads. At least one upload is finished every frame.
+constexpr double TEXTURE_UPLOAD_BUDGET = 0.002;
+
+// Pixel buffers mapped for decoding at once, which bounds the memory held by
+// loads in flight.
+constexpr std::size_t TEXTURE_LOADER_MAX_IN_FLIGHT = 4;
+
+// Load TGA textures without stalling the frame. Load returns a texture showing
+// a placeholder at once; workers decode the file and build its mip chain
+// straight into a mapped pixel buffer object, and Update, on the GL thread,
+// starts the transfer to the texture with glTexImage2D from that buffer, which
+// does not wait for the copy.
+// https://www.songho.ca/opengl/gl_pbo.html
+class TextureLoader
+{
+    public:
+    explicit TextureLoader(unsigned int threadCount);
+    // Wait for the workers and release the buffers, the GL context must still
+    // be current.
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // A load is dropped if the texture is released before it finishes.
+    std::shared_ptr<TextureOpenGL> Load(const std::string& path);
+    // Refill an existing texture, its storage is reused when the size does not
+    // change. Only the last load of a texture is uploaded, the ones it
+    // replaces are dropped.
+    void Load(const std::string& path, const std::shared_ptr<TextureOpenGL>& texture);
+
+    // Fills width x height RGB or RGBA rows, 3 or 4 channels, on a worker.
+    using PixelSource = std::function<void(unsigned char* pixels)>;
+
+    // Same with pixels from elsewhere than a TGA, ex: a video frame. `name` is
+    // only for warnings.
+    void Load(const std::string& name, uint32_t width, uint32_t height, int channels, PixelSource source,
+              const std::shared_ptr<TextureOpenGL>& texture);
+
+    // Until then the texture keeps its previous content.
+    inline bool IsLoading(const TextureOpenGL& texture) const
+    {
+        return _latestLoads.contains(&texture);
+    }
+
+    // Drop the loads of `texture` not uploaded yet, it keeps its content. Loads
+    // not decoded yet are never decoded, a decode already running finishes
+    // and is discarded.
+    void Cancel(const TextureOpenGL& texture);
+
+    // Once per frame on the GL thread.
+    void Update();
+
+    // Loads not finished yet, and textures uploaded since the start.
+    std::size_t GetPendingCount() const;
+    inline std::size_t GetUploadCount() const
+    {
+        return _uploadCount;
+    }
+
+    // Loads cancelled before their decode started.
+    inline std::size_t GetSkippedDecodeCount() const
+    {
+        return _skippedDecodeCount;
+    }
+
+    private:
+    struct PixelBuffer
+    {
+        unsigned int id = 0;
+        std::size_t capacity = 0;
+        bool busy = false;
+    };
+
+    struct Job
+    {
+        std::string path;
+        std::weak_ptr<TextureOpenGL> texture;
+        // Its key in _latestLoads, still valid to compare once released.
+        const TextureOpenGL* target = nullptr;
+        uint64_t ticket = 0;
+        // Decodes instead of the TGA at `path` when set.
+        PixelSource source;
+        std::unique_ptr<MappedFile> file;
+        // Only the size and channels for a source.
+        TGAInfo info;
+        std::vector<MipLevel> levels;
+        PixelBuffer* buffer = nullptr;
+        unsigned char* pixels = nullptr;
+        // Set by the worker when the decode failed.
+        std::string error;
+    };
+
+    void Work();
+    bool Start(std::unique_ptr<Job>& job);
+    void Finish(Job& job);
+    bool IsLatest(const Job& job) const;
+    void Forget(const Job& job);
+
+    // Only touched by the GL thread: jobs waiting for a pixel buffer, and
+    // decoded ones waiting for their upload. Jobs point into _buffers, which
+    // is never resized.
+    std::deque<std::unique_ptr<Job>> _waiting;
+    std::deque<std::unique_ptr<Job>> _uploading;
+    std::vector<PixelBuffer> _buffers;
+    std::size_t _uploadCount = 0;
+    std::size_t _skippedDecodeCount = 0;
+    // The ticket of the last load of each texture with one in flight. Decodes
+    // finish in any order, an older one must not overwrite a newer one.
+    std::unordered_map<const TextureOpenGL*, uint64_t> _latestLoads;
+    uint64_t _nextTicket = 0;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<std::unique_ptr<Job>> _decoding;
+    std::vector<std::unique_ptr<Job>> _decoded;
+    bool _stopping = false;
+
+    // Started last, once every other member is ready.
+    std::vector<std::thread> _threads;
+};
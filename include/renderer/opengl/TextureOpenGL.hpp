@@ -1,26 +1,80 @@
 #pragma once
 
 #include "ITexture.hpp"
+#include "ImageMipmap.hpp"
+#include "TextureCompression.hpp"
 #include <cstdint>
 #include <memory>
-#include <vector>
+#include <span>
 
-struct tImageTGA
-{
-    std::vector<unsigned char> data;
-    int channels;
-    int sizeX;
-    int sizeY;
-};
+class TextureResidency;
+
+// Sharpness of textures seen at grazing angles, capped by the driver. 1 turns
+// anisotropic filtering off.
+constexpr float TEXTURE_MAX_ANISOTROPY = 8.0f;
+
+// Trilinear filtering with anisotropy when the texture bound to `target` has a
+// mip chain, bilinear otherwise.
+void SetTextureFiltering(unsigned int target, bool mipmapped);
+
+// BC4 is core since GL 3.0, BC1 and BC3 need GL_EXT_texture_compression_s3tc.
+// Textures in a format the driver lacks upload uncompressed.
+bool IsBlockFormatSupported(BlockFormat format);
 
 class TextureOpenGL : public ITexture
 {
     public:
+    // Block compressed when the driver supports the format, through the cache
+    // next to the file.
     TextureOpenGL(const std::string& path);
+    // A 1x1 black placeholder until Upload gives it its pixels.
+    TextureOpenGL();
     ~TextureOpenGL();
 
+    TextureOpenGL(const TextureOpenGL&) = delete;
+    TextureOpenGL& operator=(const TextureOpenGL&) = delete;
+
+    // Replace the content with RGB or RGBA rows, 3 or 4 channels, and the
+    // other levels of `levels` when given. While a GL_PIXEL_UNPACK_BUFFER is
+    // bound, `pixels` is an offset in it. Storage of the same size and level
+    // count is overwritten rather than allocated again.
+    void Upload(uint32_t width, uint32_t height, int channels, const void* pixels,
+                std::span<const MipLevel> levels = {});
+    // Same with levels laid out by GetCompressedLevels.
+    void UploadCompressed(uint32_t width, uint32_t height, BlockFormat format, const unsigned char* blocks,
+                          std::span<const MipLevel> levels);
+
     void Bind(unsigned int slot = 0) const override;
     void Unbind();
+
+    // Release the storage for a 1x1 black placeholder, until the next upload,
+    // or until Reload for a texture loaded from a file.
+    void Evict();
+    void Reload();
+
+    // Set by TextureResidency::Add, which is then told of every bind and
+    // upload.
+    inline void SetResidency(TextureResidency* residency)
+    {
+        _residency = residency;
+    }
+
+    // Of the storage on the GPU, every level included.
+    inline std::size_t GetByteSize() const
+    {
+        return _byteSize;
+    }
+
+    inline bool IsEvicted() const
+    {
+        return _evicted;
+    }
+
+    inline bool HasFile() const
+    {
+        return !_filePath.empty();
+    }
+
     virtual inline uint32_t GetWidth() const override
     {
         return _width;
@@ -31,15 +85,24 @@ class TextureOpenGL : public ITexture
         return _height;
     }
 
-    // https://nehe.gamedev.net/tutorial/loading_compressed_and_uncompressed_tga%27s/22001/
-    // https://github.com/gamedev-net/nehe-opengl/blob/master/glut/lesson22/lesson22_glut/src/tga.cpp
-    void LoadTGA(const std::string& filename);
+    virtual inline bool IsReady() const override
+    {
+        return _ready;
+    }
 
     private:
+    void Load();
+    void CreatePlaceholder();
+    void OnStorageChanged();
+
+    TextureResidency* _residency;
     unsigned int _rendererID;
     std::string _filePath;
-    std::unique_ptr<unsigned char[]> _localBuffer;
     uint32_t _width;
     uint32_t _height;
-    uint32_t _BPP;
+    // Of the RGBA8 storage, 0 once it holds compressed blocks.
+    std::size_t _levelCount;
+    std::size_t _byteSize;
+    bool _ready;
+    bool _evicted;
 };
\ No newline at end of file
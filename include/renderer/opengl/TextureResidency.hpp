@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+class ITexture;
+class TextureOpenGL;
+
+// Bytes of texture storage kept on the GPU before the least recently used
+// textures are released.
+constexpr std::size_t TEXTURE_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+// Tracks the storage of every texture registered with Add, in the order they
+// were last bound or uploaded. Trim releases the storage of the least recently
+// used ones until the total fits the budget; they show a placeholder until
+// filled again. Textures with a file reload it on their next bind, others are
+// refilled by their owner, see TextureOpenGL::IsEvicted. Pinned textures are
+// never released. Only used from the GL thread.
+class TextureResidency
+{
+    public:
+    explicit TextureResidency(std::size_t budget = TEXTURE_MEMORY_BUDGET);
+
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    // The texture unregisters itself when destroyed.
+    void Add(TextureOpenGL& texture);
+    void Remove(const TextureOpenGL& texture);
+    // Ignored for textures not registered, ex: from another renderer.
+    void SetPinned(const ITexture& texture, bool pinned);
+
+    // Called by the texture when bound, and when its storage changes.
+    void Touch(const TextureOpenGL& texture);
+    void Resize(const TextureOpenGL& texture, std::size_t byteSize, bool reloaded);
+
+    // Once per frame, before any bind of the next one.
+    void Trim();
+
+    inline void SetBudget(std::size_t budget)
+    {
+        _budget = budget;
+    }
+
+    inline std::size_t GetBudget() const
+    {
+        return _budget;
+    }
+
+    // Storage of the registered textures, and how many times one was released
+    // or filled again since the start.
+    inline std::size_t GetUsedBytes() const
+    {
+        return _usedBytes;
+    }
+
+    inline uint64_t GetEvictionCount() const
+    {
+        return _evictionCount;
+    }
+
+    inline uint64_t GetReloadCount() const
+    {
+        return _reloadCount;
+    }
+
+    private:
+    struct Entry
+    {
+        TextureOpenGL* texture;
+        std::size_t byteSize = 0;
+        bool pinned = false;
+    };
+
+    // Least recently used first.
+    std::list<Entry> _entries;
+    std::unordered_map<const ITexture*, std::list<Entry>::iterator> _lookup;
+    std::size_t _budget;
+    std::size_t _usedBytes = 0;
+    uint64_t _evictionCount = 0;
+    uint64_t _reloadCount = 0;
+};
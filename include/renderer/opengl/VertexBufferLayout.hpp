@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One attribute of a vertex, ex: 3 GL_FLOAT for a position.
+struct VertexBufferElement
+{
+    uint32_t type;
+    uint32_t count;
+    bool normalized;
+    uint32_t offset;
+
+    static uint32_t GetSizeOfType(uint32_t type);
+};
+
+// Describes how the attributes of a vertex are laid out in a VertexBuffer, so
+// the same code can set up float or quantized vertices. Element i is bound to
+// the shader attribute at location firstLocation + i.
+class VertexBufferLayout
+{
+    public:
+    VertexBufferLayout() : _elements(), _stride(0)
+    {
+    }
+
+    void Push(uint32_t type, uint32_t count, bool normalized = false);
+
+    // Enable and describe every element on the currently bound vertex array and
+    // GL_ARRAY_BUFFER.
+    void Apply(uint32_t firstLocation = 0) const;
+
+    inline const std::vector<VertexBufferElement>& GetElements() const
+    {
+        return _elements;
+    }
+
+    inline uint32_t GetStride() const
+    {
+        return _stride;
+    }
+
+    private:
+    std::vector<VertexBufferElement> _elements;
+    uint32_t _stride;
+};
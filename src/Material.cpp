@@ -0,0 +1,129 @@
+#include "Material.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+
+inline bool IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// The value of a statement, blanks trimmed on both ends.
+std::string_view ParseValue(std::string_view line)
+{
+    while (!line.empty() && IsBlank(line.front()))
+    {
+        line.remove_prefix(1);
+    }
+    while (!line.empty() && IsBlank(line.back()))
+    {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+Vector3 ParseColor(std::string_view value)
+{
+    float rgb[3];
+    const char* it = value.data();
+    const char* end = value.data() + value.size();
+    std::size_t count = 0;
+
+    while (count < 3 && it < end)
+    {
+        while (it < end && IsBlank(*it))
+        {
+            ++it;
+        }
+        const auto [ptr, ec] = std::from_chars(it, end, rgb[count]);
+        if (ec != std::errc())
+        {
+            break;
+        }
+        it = ptr;
+        ++count;
+    }
+
+    // "Kd 0.5" sets the three components.
+    if (count == 1)
+    {
+        return Vector3(rgb[0], rgb[0], rgb[0]);
+    }
+    if (count != 3)
+    {
+        throw std::runtime_error("Error: invalid color in mtl.");
+    }
+    return Vector3(rgb[0], rgb[1], rgb[2]);
+}
+
+// Options such as "-s 1 1 1" may come before the file name, which is always
+// the last token.
+std::string_view ParseMapFile(std::string_view value)
+{
+    const std::size_t blank = value.find_last_of(" \t");
+    return blank == std::string_view::npos ? value : value.substr(blank + 1);
+}
+
+} // namespace
+
+void LoadMaterialLibrary(const std::string& filename, std::vector<Material>& materials)
+{
+    const MappedFile file(filename);
+    const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    std::string_view text = file.GetView();
+
+    const std::size_t firstMaterial = materials.size();
+    Material* current = nullptr;
+
+    while (!text.empty())
+    {
+        const std::size_t newline = text.find('\n');
+        std::string_view line = ParseValue(text.substr(0, newline));
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+
+        const std::size_t typeEnd = std::min(line.find_first_of(" \t"), line.size());
+        const std::string_view type = line.substr(0, typeEnd);
+        const std::string_view value = ParseValue(line.substr(typeEnd));
+
+        if (type == "newmtl")
+        {
+            const auto defined = std::find_if(materials.begin(), materials.end(),
+                                              [&](const Material& material) { return material.name == value; });
+
+            // Statements of a redefined material are read and dropped.
+            current = nullptr;
+            if (defined == materials.end())
+            {
+                materials.push_back(Material{std::string(value), Vector3(1, 1, 1), std::string()});
+                current = &materials.back();
+            }
+        }
+        else if (!current)
+        {
+            continue;
+        }
+        else if (type == "Kd")
+        {
+            current->diffuse = ParseColor(value);
+        }
+        else if (type == "map_Kd" && !value.empty())
+        {
+            // Exporters on Windows write backslashes.
+            std::string map(ParseMapFile(value));
+            std::replace(map.begin(), map.end(), '\\', '/');
+            current->diffuseMap = (directory / map).string();
+        }
+    }
+
+    if (materials.size() == firstMaterial)
+    {
+        std::cerr << "Warning: no material in " << filename << "\n";
+    }
+}
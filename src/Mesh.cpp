@@ -0,0 +1,95 @@
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+Mesh::Mesh(Model&& model, bool keepPositions)
+    : _centroid(model._centroid), _boundsMin(model._boundsMin), _boundsMax(model._boundsMax),
+      _sphereCenter(model._sphereCenter), _sphereRadius(model._sphereRadius), _indexCount(model.GetIndexData().size()),
+      _lods(std::move(model._lods)), _meshlets(std::move(model._meshlets)),
+      _submeshes(std::move(model._submeshes)), _submeshRanges(std::move(model._submeshRanges)),
+      _submeshStrings(std::move(model._submeshStrings)), _materials(std::move(model._materials)),
+      _submeshMaterials(std::move(model._submeshMaterials)), _positions(), _triangles(),
+      _bvhVertices(), _bvhTriangles(), _bvhThreadCount(model._bvhThreadCount), _bvh()
+{
+    const std::span<const float> vertices = model.GetVertexData();
+    const std::span<const uint32_t> indices = model.GetIndexData();
+    const MeshLod& full = _lods[0];
+
+    if (_bvhThreadCount > 0)
+    {
+        _bvhVertices.assign(vertices.begin(), vertices.end());
+        _bvhTriangles.assign(indices.begin() + full.indexOffset, indices.begin() + full.indexOffset + full.indexCount);
+    }
+
+    if (keepPositions)
+    {
+        _positions.reserve(vertices.size() / 5);
+        for (std::size_t i = 0; i < vertices.size(); i += 5)
+        {
+            _positions.emplace_back(vertices[i], vertices[i + 1], vertices[i + 2]);
+        }
+        _triangles.assign(indices.begin() + full.indexOffset, indices.begin() + full.indexOffset + full.indexCount);
+    }
+
+    // Containers keep their capacity when filled by push_back.
+    _lods.shrink_to_fit();
+    _meshlets.shrink_to_fit();
+    _submeshRanges.shrink_to_fit();
+}
+
+std::string_view Mesh::GetSubmeshName(std::size_t submesh) const
+{
+    const Submesh& s = _submeshes[submesh];
+    return std::string_view(_submeshStrings).substr(s.nameOffset, s.nameLength);
+}
+
+std::string_view Mesh::GetSubmeshMaterial(std::size_t submesh) const
+{
+    const Submesh& s = _submeshes[submesh];
+    return std::string_view(_submeshStrings).substr(s.materialOffset, s.materialLength);
+}
+
+const MeshBvh* Mesh::GetBvh()
+{
+    if (!_bvh && _bvhThreadCount > 0)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        _bvh = std::make_unique<MeshBvh>(_bvhTriangles, _bvhVertices, 5, _bvhThreadCount);
+        _bvhVertices = std::vector<float>();
+        _bvhTriangles = std::vector<uint32_t>();
+
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Built a BVH of " << _bvh->GetNodes().size() << " nodes in " << elapsed.count() << " ms ("
+                  << _bvh->GetMemoryUsage() / 1024 << " KiB)\n";
+    }
+    return _bvh.get();
+}
+
+std::size_t Mesh::FindSubmesh(uint32_t triangle) const
+{
+    // Level 0 ranges follow each other in submesh order.
+    const std::span<const MeshRange> ranges(_submeshRanges.data(), _submeshes.size());
+    const auto next =
+        std::upper_bound(ranges.begin(), ranges.end(), triangle * 3,
+                         [](uint32_t index, const MeshRange& range) { return index < range.indexOffset; });
+    return std::max<std::ptrdiff_t>(next - ranges.begin() - 1, 0);
+}
+
+std::size_t Mesh::GetMemoryUsage() const
+{
+    std::size_t bytes = sizeof(*this) + _lods.capacity() * sizeof(MeshLod) + _meshlets.capacity() * sizeof(Meshlet) +
+                        _submeshes.capacity() * sizeof(Submesh) + _submeshRanges.capacity() * sizeof(MeshRange) +
+                        _submeshStrings.capacity() + _submeshMaterials.capacity() * sizeof(uint32_t) +
+                        _positions.capacity() * sizeof(Vector3) + _triangles.capacity() * sizeof(uint32_t) +
+                        _bvhVertices.capacity() * sizeof(float) + _bvhTriangles.capacity() * sizeof(uint32_t) +
+                        (_bvh ? _bvh->GetMemoryUsage() : 0);
+
+    for (const Material& material : _materials)
+    {
+        bytes += sizeof(Material) + material.name.capacity() + material.diffuseMap.capacity();
+    }
+    return bytes;
+}
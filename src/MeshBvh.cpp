@@ -0,0 +1,474 @@
+#include "MeshBvh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <thread>
+
+namespace
+{
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+// Relative costs of visiting a node and of testing a triangle.
+constexpr float TRAVERSAL_COST = 1.0f;
+constexpr float INTERSECTION_COST = 1.0f;
+
+// Trees never get deeper, the traversal pushes at most one node per level.
+constexpr uint32_t STACK_SIZE = 64;
+constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+inline Vector3 Sub(const Vector3& a, const Vector3& b)
+{
+    return Vector3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+    return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline float Dot(const Vector3& a, const Vector3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline float Axis(const Vector3& v, int axis)
+{
+    return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+struct Bounds
+{
+    Vector3 min = Vector3(INF, INF, INF);
+    Vector3 max = Vector3(-INF, -INF, -INF);
+
+    void Grow(const Vector3& p)
+    {
+        min = Vector3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = Vector3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+
+    void Grow(const Bounds& b)
+    {
+        Grow(b.min);
+        Grow(b.max);
+    }
+
+    float HalfArea() const
+    {
+        const Vector3 e = Sub(max, min);
+        return e.x < 0.0f ? 0.0f : e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+};
+
+class BvhBuilder
+{
+    public:
+    BvhBuilder(std::span<const uint32_t> indices, std::span<const float> vertices, std::size_t stride)
+        : _bounds(indices.size() / 3), _centroids(indices.size() / 3), _order(indices.size() / 3)
+    {
+        for (std::size_t t = 0; t < _order.size(); ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const float* p = &vertices[indices[t * 3 + k] * stride];
+                _bounds[t].Grow(Vector3(p[0], p[1], p[2]));
+            }
+            const Bounds& b = _bounds[t];
+            _centroids[t] = Vector3((b.min.x + b.max.x) * 0.5f, (b.min.y + b.max.y) * 0.5f, (b.min.z + b.max.z) * 0.5f);
+            _order[t] = t;
+        }
+    }
+
+    // Root first. The subtrees of the first `spawnDepth` levels are built on
+    // their own threads, then spliced after the root.
+    std::vector<BvhNode> Build(uint32_t first, uint32_t count, uint32_t depth, uint32_t spawnDepth)
+    {
+        std::vector<BvhNode> nodes(1);
+        uint32_t middle = 0;
+
+        if (!Split(nodes[0], first, count, depth, middle))
+        {
+            return nodes;
+        }
+
+        if (spawnDepth == 0 || count < BVH_PARALLEL_MIN_TRIANGLES)
+        {
+            nodes[0].first = 1;
+            nodes.resize(3);
+            BuildInto(nodes, 1, first, middle - first, depth + 1);
+            BuildInto(nodes, 2, middle, first + count - middle, depth + 1);
+            return nodes;
+        }
+
+        std::vector<BvhNode> left;
+        std::exception_ptr error;
+        std::thread worker([&]() {
+            try
+            {
+                left = Build(first, middle - first, depth + 1, spawnDepth - 1);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        });
+        const std::vector<BvhNode> right = Build(middle, first + count - middle, depth + 1, spawnDepth - 1);
+        worker.join();
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        // Children go to 1 and 2, then the rest of the left subtree, then the
+        // rest of the right one.
+        const auto splice = [&](const std::vector<BvhNode>& subtree, uint32_t root, uint32_t offset) {
+            const auto remap = [&](BvhNode node) {
+                if (node.triangleCount == 0)
+                {
+                    node.first += offset - 1;
+                }
+                return node;
+            };
+            nodes[root] = remap(subtree[0]);
+            for (std::size_t i = 1; i < subtree.size(); ++i)
+            {
+                nodes.push_back(remap(subtree[i]));
+            }
+        };
+
+        nodes[0].first = 1;
+        nodes.resize(3);
+        nodes.reserve(1 + left.size() + right.size());
+        splice(left, 1, 3);
+        splice(right, 2, 3 + left.size() - 1);
+        return nodes;
+    }
+
+    const std::vector<uint32_t>& GetOrder() const
+    {
+        return _order;
+    }
+
+    private:
+    void BuildInto(std::vector<BvhNode>& nodes, uint32_t index, uint32_t first, uint32_t count, uint32_t depth)
+    {
+        BvhNode node{};
+        uint32_t middle = 0;
+
+        if (!Split(node, first, count, depth, middle))
+        {
+            nodes[index] = node;
+            return;
+        }
+
+        // Children are allocated before recursing, so they stay next to each
+        // other.
+        node.first = nodes.size();
+        nodes[index] = node;
+        nodes.resize(nodes.size() + 2);
+        BuildInto(nodes, node.first, first, middle - first, depth + 1);
+        BuildInto(nodes, node.first + 1, middle, first + count - middle, depth + 1);
+    }
+
+    // Fill the bounds of `node`. Return false for a leaf, otherwise partition
+    // [first, first + count) around `middle`.
+    bool Split(BvhNode& node, uint32_t first, uint32_t count, uint32_t depth, uint32_t& middle)
+    {
+        Bounds bounds;
+        Bounds centroidBounds;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            bounds.Grow(_bounds[_order[i]]);
+            centroidBounds.Grow(_centroids[_order[i]]);
+        }
+
+        node.boundsMin = bounds.min;
+        node.boundsMax = bounds.max;
+        node.first = first;
+        node.triangleCount = count;
+
+        // The traversal stack holds one node per level.
+        if (count <= 2 || depth + 1 >= STACK_SIZE)
+        {
+            return false;
+        }
+
+        int bestAxis = -1;
+        uint32_t bestSplit = 0;
+        float bestCost = INF;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float low = Axis(centroidBounds.min, axis);
+            const float extent = Axis(centroidBounds.max, axis) - low;
+            if (extent <= 0.0f)
+            {
+                continue;
+            }
+
+            Bounds bins[BVH_BIN_COUNT];
+            uint32_t binCounts[BVH_BIN_COUNT] = {};
+            const float scale = BVH_BIN_COUNT / extent;
+
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                const uint32_t bin = Bin(_centroids[_order[i]], axis, low, scale);
+                bins[bin].Grow(_bounds[_order[i]]);
+                ++binCounts[bin];
+            }
+
+            // Sweep from the right to get the area and count right of every
+            // plane, then from the left to evaluate them.
+            float rightAreas[BVH_BIN_COUNT];
+            uint32_t rightCounts[BVH_BIN_COUNT];
+            Bounds right;
+            uint32_t rightCount = 0;
+            for (uint32_t b = BVH_BIN_COUNT - 1; b > 0; --b)
+            {
+                right.Grow(bins[b]);
+                rightCount += binCounts[b];
+                rightAreas[b] = right.HalfArea();
+                rightCounts[b] = rightCount;
+            }
+
+            Bounds left;
+            uint32_t leftCount = 0;
+            for (uint32_t b = 0; b + 1 < BVH_BIN_COUNT; ++b)
+            {
+                left.Grow(bins[b]);
+                leftCount += binCounts[b];
+                if (leftCount == 0 || rightCounts[b + 1] == 0)
+                {
+                    continue;
+                }
+                const float cost = left.HalfArea() * leftCount + rightAreas[b + 1] * rightCounts[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+
+        const float leafCost = INTERSECTION_COST * count;
+        const float splitCost = TRAVERSAL_COST + INTERSECTION_COST * bestCost / std::max(bounds.HalfArea(), 1e-30f);
+
+        if (bestAxis < 0)
+        {
+            // Every centroid is at the same place, only the count can split.
+            if (count <= BVH_MAX_LEAF_SIZE)
+            {
+                return false;
+            }
+            middle = first + count / 2;
+            node.triangleCount = 0;
+            return true;
+        }
+
+        if (splitCost >= leafCost && count <= BVH_MAX_LEAF_SIZE)
+        {
+            return false;
+        }
+
+        const float low = Axis(centroidBounds.min, bestAxis);
+        const float scale = BVH_BIN_COUNT / (Axis(centroidBounds.max, bestAxis) - low);
+        middle = std::partition(_order.begin() + first, _order.begin() + first + count,
+                                [&](uint32_t t) { return Bin(_centroids[t], bestAxis, low, scale) < bestSplit; }) -
+                 _order.begin();
+        node.triangleCount = 0;
+        return true;
+    }
+
+    static uint32_t Bin(const Vector3& centroid, int axis, float low, float scale)
+    {
+        const float bin = (Axis(centroid, axis) - low) * scale;
+        return std::min(static_cast<uint32_t>(std::max(bin, 0.0f)), BVH_BIN_COUNT - 1);
+    }
+
+    std::vector<Bounds> _bounds;
+    std::vector<Vector3> _centroids;
+    std::vector<uint32_t> _order;
+};
+
+// Entry distance of the ray in the box, or INF if it misses it within
+// [0, maxDistance].
+inline float IntersectBounds(const BvhNode& node, const Vector3& origin, const Vector3& inverse, float maxDistance)
+{
+    const float x0 = (node.boundsMin.x - origin.x) * inverse.x;
+    const float x1 = (node.boundsMax.x - origin.x) * inverse.x;
+    const float y0 = (node.boundsMin.y - origin.y) * inverse.y;
+    const float y1 = (node.boundsMax.y - origin.y) * inverse.y;
+    const float z0 = (node.boundsMin.z - origin.z) * inverse.z;
+    const float z1 = (node.boundsMax.z - origin.z) * inverse.z;
+
+    const float near = std::max({std::min(x0, x1), std::min(y0, y1), std::min(z0, z1), 0.0f});
+    const float far = std::min({std::max(x0, x1), std::max(y0, y1), std::max(z0, z1), maxDistance});
+    return near <= far ? near : INF;
+}
+
+} // namespace
+
+MeshBvh::MeshBvh(std::span<const uint32_t> indices, std::span<const float> vertices, std::size_t stride,
+                 uint32_t threadCount)
+{
+    const uint32_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    BvhBuilder builder(indices, vertices, stride);
+
+    // One level of threads doubles the workers.
+    uint32_t spawnDepth = 0;
+    while ((1u << spawnDepth) < threadCount)
+    {
+        ++spawnDepth;
+    }
+    _nodes = builder.Build(0, triangleCount, 0, spawnDepth);
+
+    _triangles.reserve(triangleCount);
+    _uvs.reserve(triangleCount * 3);
+    for (uint32_t t : builder.GetOrder())
+    {
+        const float* p[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            p[k] = &vertices[indices[t * 3 + k] * stride];
+            _uvs.emplace_back(p[k][3], p[k][4]);
+        }
+        const Vector3 v0(p[0][0], p[0][1], p[0][2]);
+        _triangles.push_back(Triangle{v0, Sub(Vector3(p[1][0], p[1][1], p[1][2]), v0),
+                                      Sub(Vector3(p[2][0], p[2][1], p[2][2]), v0), t});
+    }
+}
+
+bool MeshBvh::Intersect(const Vector3& origin, const Vector3& direction, float maxDistance, RayHit& hit) const
+{
+    if (_nodes.empty())
+    {
+        return false;
+    }
+
+    // Division by a zero component gives an infinity, which the slab test
+    // handles.
+    const Vector3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float closest = maxDistance;
+    uint32_t closestIndex = 0;
+    float closestU = 0.0f;
+    float closestV = 0.0f;
+    bool found = false;
+
+    // Far children waiting to be visited, with their entry distance.
+    uint32_t stack[STACK_SIZE];
+    float stackDistances[STACK_SIZE];
+    uint32_t stackSize = 0;
+    const auto pop = [&]() {
+        // A far child may lie behind a hit found since it was pushed.
+        while (stackSize > 0)
+        {
+            --stackSize;
+            if (stackDistances[stackSize] <= closest)
+            {
+                return stack[stackSize];
+            }
+        }
+        return NO_NODE;
+    };
+
+    uint32_t current = IntersectBounds(_nodes[0], origin, inverse, closest) < INF ? 0 : NO_NODE;
+    while (current != NO_NODE)
+    {
+        const BvhNode& node = _nodes[current];
+
+        if (node.triangleCount > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.triangleCount; ++i)
+            {
+                const Triangle& triangle = _triangles[i];
+                const Vector3 p = Cross(direction, triangle.edge2);
+                const float determinant = Dot(triangle.edge1, p);
+                if (determinant == 0.0f)
+                {
+                    continue;
+                }
+
+                const float inverseDeterminant = 1.0f / determinant;
+                const Vector3 s = Sub(origin, triangle.v0);
+                const float u = Dot(s, p) * inverseDeterminant;
+                if (u < 0.0f || u > 1.0f)
+                {
+                    continue;
+                }
+
+                const Vector3 q = Cross(s, triangle.edge1);
+                const float v = Dot(direction, q) * inverseDeterminant;
+                if (v < 0.0f || u + v > 1.0f)
+                {
+                    continue;
+                }
+
+                const float t = Dot(triangle.edge2, q) * inverseDeterminant;
+                if (t >= 0.0f && t <= closest)
+                {
+                    closest = t;
+                    closestIndex = i;
+                    closestU = u;
+                    closestV = v;
+                    found = true;
+                }
+            }
+            current = pop();
+            continue;
+        }
+
+        // Visit the nearer child first, the farther one may be skipped once a
+        // closer hit is known.
+        uint32_t nearChild = node.first;
+        uint32_t farChild = node.first + 1;
+        float nearDistance = IntersectBounds(_nodes[nearChild], origin, inverse, closest);
+        float farDistance = IntersectBounds(_nodes[farChild], origin, inverse, closest);
+        if (farDistance < nearDistance)
+        {
+            std::swap(nearChild, farChild);
+            std::swap(nearDistance, farDistance);
+        }
+
+        if (nearDistance == INF)
+        {
+            current = pop();
+            continue;
+        }
+        if (farDistance != INF)
+        {
+            stack[stackSize] = farChild;
+            stackDistances[stackSize++] = farDistance;
+        }
+        current = nearChild;
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    const Vector2* uvs = &_uvs[closestIndex * 3];
+    const float w = 1.0f - closestU - closestV;
+    hit.triangle = _triangles[closestIndex].id;
+    hit.distance = closest;
+    hit.u = closestU;
+    hit.v = closestV;
+    hit.uv = Vector2(w * uvs[0].u + closestU * uvs[1].u + closestV * uvs[2].u,
+                     w * uvs[0].v + closestU * uvs[1].v + closestV * uvs[2].v);
+    return true;
+}
+
+std::size_t MeshBvh::GetMemoryUsage() const
+{
+    return _nodes.capacity() * sizeof(BvhNode) + _triangles.capacity() * sizeof(Triangle) +
+           _uvs.capacity() * sizeof(Vector2);
+}
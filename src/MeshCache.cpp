@@ -0,0 +1,350 @@
+#include "MeshCache.hpp"
+#include "Model.hpp"
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+
+constexpr char MESH_CACHE_MAGIC[8] = {'S', 'C', 'O', 'P', 'M', 'E', 'S', 'H'};
+
+static_assert(sizeof(MeshCacheHeader) % 8 == 0, "Payload must stay aligned after the header");
+
+// 64-bit hash that eats 8 bytes per step, fast enough to check a multi-gigabyte
+// OBJ far quicker than it could be parsed. Not cryptographic, it only needs to
+// tell an edited file apart.
+uint64_t HashBytes(const char* data, std::size_t size)
+{
+    constexpr uint64_t k0 = 0x9e3779b97f4a7c15ULL;
+    constexpr uint64_t k1 = 0xbf58476d1ce4e5b9ULL;
+
+    uint64_t hash = size * k0;
+    std::size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = std::rotl(hash ^ (word * k1), 31) * k0;
+    }
+
+    uint64_t tail = 0;
+    if (i < size)
+    {
+        std::memcpy(&tail, data + i, size - i);
+    }
+    hash = std::rotl(hash ^ (tail * k1), 31) * k0;
+
+    hash ^= hash >> 32;
+    hash *= k1;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+// The sections of the payload, in file order.
+struct MeshCachePayload
+{
+    std::span<const float> vertices;
+    std::span<const uint32_t> indices;
+    std::span<const MeshLod> lods;
+    std::span<const Meshlet> meshlets;
+    std::span<const Submesh> submeshes;
+    std::span<const MeshRange> submeshRanges;
+    std::string_view strings;
+    std::string_view libraries;
+
+    template <typename Function> void ForEachSection(Function function) const
+    {
+        function(reinterpret_cast<const char*>(vertices.data()), vertices.size_bytes());
+        function(reinterpret_cast<const char*>(indices.data()), indices.size_bytes());
+        function(reinterpret_cast<const char*>(lods.data()), lods.size_bytes());
+        function(reinterpret_cast<const char*>(meshlets.data()), meshlets.size_bytes());
+        function(reinterpret_cast<const char*>(submeshes.data()), submeshes.size_bytes());
+        function(reinterpret_cast<const char*>(submeshRanges.data()), submeshRanges.size_bytes());
+        function(strings.data(), strings.size());
+        function(libraries.data(), libraries.size());
+    }
+};
+
+// Each section is hashed separately, so writing the cache does not need to
+// concatenate them in memory first.
+uint64_t HashPayload(const MeshCachePayload& payload)
+{
+    uint64_t hash = 0;
+    int rotation = 0;
+
+    payload.ForEachSection([&](const char* data, std::size_t size) {
+        hash ^= std::rotl(HashBytes(data, size), rotation++);
+    });
+    return hash;
+}
+
+MeshCachePayload GetPayload(const MeshCache& cache)
+{
+    return MeshCachePayload{cache.GetVertices(),  cache.GetIndices(),       cache.GetLods(),
+                            cache.GetMeshlets(),  cache.GetSubmeshes(),     cache.GetSubmeshRanges(),
+                            cache.GetSubmeshStrings(), cache.GetMaterialLibraries()};
+}
+
+} // namespace
+
+MeshCacheKey MeshCache::MakeKey(const std::string& sourcePath, const MappedFile& source)
+{
+    const auto time = std::filesystem::last_write_time(sourcePath).time_since_epoch().count();
+
+    return MeshCacheKey{source.GetSize(), static_cast<int64_t>(time), HashBytes(source.GetData(), source.GetSize())};
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath)
+{
+    return sourcePath + MESH_CACHE_EXTENSION;
+}
+
+MeshCache::MeshCache(std::unique_ptr<MappedFile> file, const MeshCacheHeader& header)
+    : _file(std::move(file)), _header(header)
+{
+}
+
+std::unique_ptr<MeshCache> MeshCache::Open(const std::string& sourcePath, const MeshCacheKey& key, uint32_t flags)
+{
+    const std::string path = GetCachePath(sourcePath);
+    std::error_code error;
+
+    if (!std::filesystem::exists(path, error))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file;
+
+    try
+    {
+        file = std::make_unique<MappedFile>(path);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Warning: ignoring mesh cache: " << ex.what() << "\n";
+        return nullptr;
+    }
+
+    MeshCacheHeader header;
+
+    if (file->GetSize() < sizeof(header))
+    {
+        std::cerr << "Warning: ignoring truncated mesh cache: " << path << "\n";
+        return nullptr;
+    }
+
+    std::memcpy(&header, file->GetData(), sizeof(header));
+
+    if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+        header.version != MESH_CACHE_VERSION || header.headerSize != sizeof(header))
+    {
+        std::cerr << "Warning: ignoring mesh cache from another version: " << path << "\n";
+        return nullptr;
+    }
+
+    if (header.key.sourceSize != key.sourceSize || header.key.sourceTime != key.sourceTime ||
+        header.key.sourceHash != key.sourceHash || header.flags != flags)
+    {
+        // The OBJ or the load options changed since the cache was written,
+        // rebuild it silently.
+        return nullptr;
+    }
+
+    // Check the counts on their own first, a garbage count could overflow the
+    // payload size below.
+    const uint64_t maxElements = file->GetSize() / sizeof(float);
+
+    const uint64_t rangeCount = static_cast<uint64_t>(header.lodCount) * header.submeshCount;
+
+    if (header.vertexFloatCount > maxElements || header.indexCount > maxElements || header.lodCount > maxElements ||
+        header.meshletCount > maxElements || header.submeshCount > maxElements || rangeCount > maxElements ||
+        file->GetSize() - sizeof(header) !=
+            header.vertexFloatCount * sizeof(float) + header.indexCount * sizeof(uint32_t) +
+                header.lodCount * sizeof(MeshLod) + header.meshletCount * sizeof(Meshlet) +
+                header.submeshCount * sizeof(Submesh) + rangeCount * sizeof(MeshRange) + header.stringsSize +
+                header.librariesSize ||
+        header.vertexFloatCount % 5 != 0 || header.lodCount == 0 || header.submeshCount == 0)
+    {
+        std::cerr << "Warning: ignoring corrupt mesh cache: " << path << "\n";
+        return nullptr;
+    }
+
+    std::unique_ptr<MeshCache> cache(new MeshCache(std::move(file), header));
+
+    if (HashPayload(GetPayload(*cache)) != header.payloadHash)
+    {
+        std::cerr << "Warning: ignoring corrupt mesh cache: " << path << "\n";
+        return nullptr;
+    }
+
+    const auto outOfRange = [](uint32_t offset, uint32_t count, uint64_t size) {
+        return offset > size || count > size - offset;
+    };
+
+    for (const MeshLod& lod : cache->GetLods())
+    {
+        if (outOfRange(lod.indexOffset, lod.indexCount, header.indexCount) ||
+            outOfRange(lod.meshletOffset, lod.meshletCount, header.meshletCount))
+        {
+            std::cerr << "Warning: ignoring corrupt mesh cache: " << path << "\n";
+            return nullptr;
+        }
+    }
+
+    for (const Meshlet& meshlet : cache->GetMeshlets())
+    {
+        if (outOfRange(meshlet.indexOffset, meshlet.indexCount, header.indexCount))
+        {
+            std::cerr << "Warning: ignoring corrupt mesh cache: " << path << "\n";
+            return nullptr;
+        }
+    }
+
+    for (const Submesh& submesh : cache->GetSubmeshes())
+    {
+        if (outOfRange(submesh.nameOffset, submesh.nameLength, header.stringsSize) ||
+            outOfRange(submesh.materialOffset, submesh.materialLength, header.stringsSize))
+        {
+            std::cerr << "Warning: ignoring corrupt mesh cache: " << path << "\n";
+            return nullptr;
+        }
+    }
+
+    for (const MeshRange& range : cache->GetSubmeshRanges())
+    {
+        if (outOfRange(range.indexOffset, range.indexCount, header.indexCount) ||
+            outOfRange(range.meshletOffset, range.meshletCount, header.meshletCount))
+        {
+            std::cerr << "Warning: ignoring corrupt mesh cache: " << path << "\n";
+            return nullptr;
+        }
+    }
+    return cache;
+}
+
+bool MeshCache::Write(const std::string& sourcePath, const MeshCacheKey& key, uint32_t flags, const Model& model)
+{
+    std::string libraries;
+    for (const std::string& library : model._materialLibraries)
+    {
+        libraries += library + '\n';
+    }
+
+    const MeshCachePayload payload{model.GetVertexData(), model.GetIndexData(), model.GetLods(),
+                                   model.GetMeshlets(),   model.GetSubmeshes(), model._submeshRanges,
+                                   model._submeshStrings, libraries};
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.headerSize = sizeof(header);
+    header.key = key;
+    header.vertexFloatCount = payload.vertices.size();
+    header.indexCount = payload.indices.size();
+    header.centroid = model._centroid;
+    header.boundsMin = model._boundsMin;
+    header.boundsMax = model._boundsMax;
+    header.sphereCenter = model._sphereCenter;
+    header.sphereRadius = model._sphereRadius;
+    header.flags = flags;
+    header.lodCount = payload.lods.size();
+    header.meshletCount = payload.meshlets.size();
+    header.submeshCount = payload.submeshes.size();
+    header.stringsSize = payload.strings.size();
+    header.librariesSize = payload.libraries.size();
+
+    header.payloadHash = HashPayload(payload);
+
+    // Write to a temporary file renamed at the end, a crash or a concurrent
+    // reader never sees a half written cache.
+    const std::string path = GetCachePath(sourcePath);
+    const std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            std::cerr << "Warning: cannot write mesh cache: " << path << "\n";
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        payload.ForEachSection([&](const char* data, std::size_t size) { file.write(data, size); });
+
+        if (!file.good())
+        {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            std::cerr << "Warning: cannot write mesh cache: " << path << "\n";
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    if (error)
+    {
+        std::remove(temporaryPath.c_str());
+        std::cerr << "Warning: cannot write mesh cache: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::span<const float> MeshCache::GetVertices() const
+{
+    const float* data = reinterpret_cast<const float*>(_file->GetData() + sizeof(MeshCacheHeader));
+    return std::span<const float>(data, _header.vertexFloatCount);
+}
+
+std::span<const uint32_t> MeshCache::GetIndices() const
+{
+    const char* data = _file->GetData() + sizeof(MeshCacheHeader) + _header.vertexFloatCount * sizeof(float);
+    return std::span<const uint32_t>(reinterpret_cast<const uint32_t*>(data), _header.indexCount);
+}
+
+std::span<const MeshLod> MeshCache::GetLods() const
+{
+    const char* data = _file->GetData() + sizeof(MeshCacheHeader) + _header.vertexFloatCount * sizeof(float) +
+                       _header.indexCount * sizeof(uint32_t);
+    return std::span<const MeshLod>(reinterpret_cast<const MeshLod*>(data), _header.lodCount);
+}
+
+std::span<const Meshlet> MeshCache::GetMeshlets() const
+{
+    const char* data = reinterpret_cast<const char*>(GetLods().data()) + _header.lodCount * sizeof(MeshLod);
+    return std::span<const Meshlet>(reinterpret_cast<const Meshlet*>(data), _header.meshletCount);
+}
+
+std::span<const Submesh> MeshCache::GetSubmeshes() const
+{
+    const char* data = reinterpret_cast<const char*>(GetMeshlets().data()) + _header.meshletCount * sizeof(Meshlet);
+    return std::span<const Submesh>(reinterpret_cast<const Submesh*>(data), _header.submeshCount);
+}
+
+std::span<const MeshRange> MeshCache::GetSubmeshRanges() const
+{
+    const char* data = reinterpret_cast<const char*>(GetSubmeshes().data()) + _header.submeshCount * sizeof(Submesh);
+    return std::span<const MeshRange>(reinterpret_cast<const MeshRange*>(data),
+                                      static_cast<std::size_t>(_header.lodCount) * _header.submeshCount);
+}
+
+std::string_view MeshCache::GetSubmeshStrings() const
+{
+    const std::span<const MeshRange> ranges = GetSubmeshRanges();
+    return std::string_view(reinterpret_cast<const char*>(ranges.data() + ranges.size()), _header.stringsSize);
+}
+
+std::string_view MeshCache::GetMaterialLibraries() const
+{
+    const std::string_view strings = GetSubmeshStrings();
+    return std::string_view(strings.data() + strings.size(), _header.librariesSize);
+}
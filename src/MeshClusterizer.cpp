@@ -0,0 +1,303 @@
+#include "MeshClusterizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+
+// Below this fill, a meshlet that ran out of connected triangles keeps growing
+// from the next unused one rather than staying almost empty.
+constexpr uint32_t MESHLET_MIN_TRIANGLES = MESHLET_MAX_TRIANGLES / 4;
+
+constexpr uint32_t NO_TRIANGLE = std::numeric_limits<uint32_t>::max();
+
+inline Vector3 Sub(const Vector3& a, const Vector3& b)
+{
+    return Vector3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+    return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline float Dot(const Vector3& a, const Vector3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+class MeshletBuilder
+{
+    public:
+    MeshletBuilder(std::span<const uint32_t> indices, std::span<const float> vertices, std::size_t stride)
+        : _indices(indices), _vertices(vertices), _stride(stride), _offsets(vertices.size() / stride + 1, 0),
+          _triangles(indices.size()), _emitted(indices.size() / 3, false), _meshletOf(vertices.size() / stride, NONE)
+    {
+        for (uint32_t index : indices)
+        {
+            ++_offsets[index + 1];
+        }
+        std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+
+        std::vector<uint32_t> fill(_offsets.begin(), _offsets.end() - 1);
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            _triangles[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<Meshlet> Build(std::vector<uint32_t>& order)
+    {
+        const uint32_t triangleCount = _indices.size() / 3;
+        std::vector<Meshlet> meshlets;
+        uint32_t cursor = 0;
+        uint32_t last = NO_TRIANGLE;
+
+        order.clear();
+        order.reserve(triangleCount);
+
+        while (order.size() < triangleCount)
+        {
+            uint32_t next = last == NO_TRIANGLE ? NO_TRIANGLE : FindConnected(last);
+
+            if (next == NO_TRIANGLE)
+            {
+                if (_meshletTriangles >= MESHLET_MIN_TRIANGLES)
+                {
+                    meshlets.push_back(Close(order));
+                }
+                while (_emitted[cursor])
+                {
+                    ++cursor;
+                }
+                next = cursor;
+            }
+
+            if (!Fits(next))
+            {
+                meshlets.push_back(Close(order));
+            }
+
+            Add(next, order);
+            last = next;
+        }
+
+        if (_meshletTriangles > 0)
+        {
+            meshlets.push_back(Close(order));
+        }
+        return meshlets;
+    }
+
+    private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    Vector3 Position(uint32_t vertex) const
+    {
+        const float* p = &_vertices[vertex * _stride];
+        return Vector3(p[0], p[1], p[2]);
+    }
+
+    uint32_t NewVertexCount(uint32_t triangle) const
+    {
+        uint32_t count = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            count += _meshletOf[_indices[triangle * 3 + k]] != _meshletId;
+        }
+        return count;
+    }
+
+    bool Fits(uint32_t triangle) const
+    {
+        return _meshletTriangles < MESHLET_MAX_TRIANGLES &&
+               _meshletVertices.size() + NewVertexCount(triangle) <= MESHLET_MAX_VERTICES;
+    }
+
+    // Best unused triangle around `vertex`, the one adding the fewest vertices.
+    void ScanVertex(uint32_t vertex, uint32_t& best, uint32_t& bestCost) const
+    {
+        for (uint32_t i = _offsets[vertex]; i < _offsets[vertex + 1]; ++i)
+        {
+            const uint32_t triangle = _triangles[i];
+            if (_emitted[triangle])
+            {
+                continue;
+            }
+            const uint32_t cost = NewVertexCount(triangle);
+            if (cost < bestCost)
+            {
+                best = triangle;
+                bestCost = cost;
+            }
+        }
+    }
+
+    // Look around the last triangle first, it keeps the meshlet compact and
+    // costs a handful of lookups.
+    uint32_t FindConnected(uint32_t last) const
+    {
+        uint32_t best = NO_TRIANGLE;
+        uint32_t bestCost = NONE;
+        for (int k = 0; k < 3; ++k)
+        {
+            ScanVertex(_indices[last * 3 + k], best, bestCost);
+        }
+        return best != NO_TRIANGLE ? best : FindConnected();
+    }
+
+    uint32_t FindConnected() const
+    {
+        uint32_t best = NO_TRIANGLE;
+        uint32_t bestCost = NONE;
+        for (uint32_t vertex : _meshletVertices)
+        {
+            ScanVertex(vertex, best, bestCost);
+        }
+        return best;
+    }
+
+    void Add(uint32_t triangle, std::vector<uint32_t>& order)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint32_t vertex = _indices[triangle * 3 + k];
+            if (_meshletOf[vertex] != _meshletId)
+            {
+                _meshletOf[vertex] = _meshletId;
+                _meshletVertices.push_back(vertex);
+            }
+        }
+        _emitted[triangle] = true;
+        order.push_back(triangle);
+        ++_meshletTriangles;
+    }
+
+    Meshlet Close(const std::vector<uint32_t>& order)
+    {
+        Meshlet meshlet{};
+        const uint32_t firstTriangle = order.size() - _meshletTriangles;
+        meshlet.indexOffset = firstTriangle * 3;
+        meshlet.indexCount = _meshletTriangles * 3;
+
+        Vector3 min = Position(_meshletVertices[0]);
+        Vector3 max = min;
+        for (uint32_t vertex : _meshletVertices)
+        {
+            const Vector3 p = Position(vertex);
+            min = Vector3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+            max = Vector3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+        }
+        meshlet.center = Vector3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+
+        float radiusSquared = 0.0f;
+        for (uint32_t vertex : _meshletVertices)
+        {
+            const Vector3 d = Sub(Position(vertex), meshlet.center);
+            radiusSquared = std::max(radiusSquared, Dot(d, d));
+        }
+        meshlet.radius = std::sqrt(radiusSquared);
+
+        // The cone axis is the average normal, its half angle the widest normal
+        // around it. Degenerate triangles have no facing and are skipped.
+        std::vector<Vector3>& normals = _normalScratch;
+        normals.clear();
+        Vector3 axis(0, 0, 0);
+        for (std::size_t i = firstTriangle; i < order.size(); ++i)
+        {
+            const uint32_t* triangle = &_indices[order[i] * 3];
+            const Vector3 p0 = Position(triangle[0]);
+            const Vector3 n = Cross(Sub(Position(triangle[1]), p0), Sub(Position(triangle[2]), p0));
+            const float length = std::sqrt(Dot(n, n));
+            if (length > 0.0f)
+            {
+                normals.push_back(Vector3(n.x / length, n.y / length, n.z / length));
+                axis = Vector3(axis.x + normals.back().x, axis.y + normals.back().y, axis.z + normals.back().z);
+            }
+        }
+
+        const float axisLength = std::sqrt(Dot(axis, axis));
+        meshlet.coneAxis = Vector3(0, 0, 0);
+        meshlet.coneCutoff = 1.0f;
+
+        if (axisLength > 0.0f)
+        {
+            axis = Vector3(axis.x / axisLength, axis.y / axisLength, axis.z / axisLength);
+            float minDot = 1.0f;
+            for (const Vector3& n : normals)
+            {
+                minDot = std::min(minDot, Dot(n, axis));
+            }
+            meshlet.coneAxis = axis;
+            // Past 90 degrees some triangle always faces the viewer.
+            meshlet.coneCutoff = minDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+        }
+
+        _meshletVertices.clear();
+        _meshletTriangles = 0;
+        ++_meshletId;
+        return meshlet;
+    }
+
+    std::span<const uint32_t> _indices;
+    std::span<const float> _vertices;
+    std::size_t _stride;
+
+    // Vertex -> triangles adjacency.
+    std::vector<uint32_t> _offsets;
+    std::vector<uint32_t> _triangles;
+
+    std::vector<bool> _emitted;
+    // Id of the last meshlet each vertex was added to.
+    std::vector<uint32_t> _meshletOf;
+
+    std::vector<uint32_t> _meshletVertices;
+    std::vector<Vector3> _normalScratch;
+    uint32_t _meshletTriangles = 0;
+    uint32_t _meshletId = 0;
+};
+
+} // namespace
+
+std::vector<Meshlet> BuildMeshlets(std::span<uint32_t> indices, std::span<const float> vertices, std::size_t stride)
+{
+    if (indices.empty())
+    {
+        return {};
+    }
+
+    std::vector<uint32_t> order;
+    std::vector<Meshlet> meshlets = MeshletBuilder(indices, vertices, stride).Build(order);
+
+    std::vector<uint32_t> reordered(indices.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        std::copy_n(&indices[order[i] * 3], 3, &reordered[i * 3]);
+    }
+
+    // Growing meshlets undoes the overdraw order, so apply it again at meshlet
+    // granularity: clusters facing outward first.
+    Vector3 meshCenter(0, 0, 0);
+    for (const Meshlet& meshlet : meshlets)
+    {
+        meshCenter = Vector3(meshCenter.x + meshlet.center.x, meshCenter.y + meshlet.center.y,
+                             meshCenter.z + meshlet.center.z);
+    }
+    const float inverseCount = 1.0f / meshlets.size();
+    meshCenter = Vector3(meshCenter.x * inverseCount, meshCenter.y * inverseCount, meshCenter.z * inverseCount);
+
+    std::stable_sort(meshlets.begin(), meshlets.end(), [&](const Meshlet& a, const Meshlet& b) {
+        return Dot(Sub(a.center, meshCenter), a.coneAxis) > Dot(Sub(b.center, meshCenter), b.coneAxis);
+    });
+
+    uint32_t offset = 0;
+    for (Meshlet& meshlet : meshlets)
+    {
+        std::copy_n(&reordered[meshlet.indexOffset], meshlet.indexCount, &indices[offset]);
+        meshlet.indexOffset = offset;
+        offset += meshlet.indexCount;
+    }
+    return meshlets;
+}
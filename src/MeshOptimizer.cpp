@@ -0,0 +1,375 @@
+#include "MeshOptimizer.hpp"
+#include "math/vector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+
+// Forsyth tunes his scores for an LRU cache a bit larger than the hardware one.
+constexpr int FORSYTH_CACHE_SIZE = 32;
+constexpr int FORSYTH_MAX_VALENCE = 32;
+
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+struct ScoreTables
+{
+    float cache[FORSYTH_CACHE_SIZE];
+    float valence[FORSYTH_MAX_VALENCE + 1];
+
+    ScoreTables()
+    {
+        for (int i = 0; i < FORSYTH_CACHE_SIZE; ++i)
+        {
+            // The 3 vertices of the last triangle get a fixed score, so the next
+            // triangle does not always pick the same edge.
+            if (i < 3)
+            {
+                cache[i] = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                cache[i] = std::pow(1.0f - (i - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        // Vertices with few triangles left are favored, so they leave the mesh
+        // before getting isolated.
+        valence[0] = 0.0f;
+        for (int i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+        {
+            valence[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+        }
+    }
+};
+
+inline float VertexScore(const ScoreTables& tables, int cachePosition, uint32_t liveTriangles)
+{
+    if (liveTriangles == 0)
+    {
+        return -1.0f;
+    }
+
+    const float cacheScore = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+    return cacheScore + tables.valence[std::min<uint32_t>(liveTriangles, FORSYTH_MAX_VALENCE)];
+}
+
+Vector3 Position(std::span<const float> vertices, std::size_t stride, uint32_t index)
+{
+    const float* p = &vertices[index * stride];
+    return Vector3(p[0], p[1], p[2]);
+}
+
+} // namespace
+
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, std::size_t vertexCount)
+{
+    if (indices.empty() || vertexCount == 0)
+    {
+        return VertexCacheStats{0.0f, 0.0f};
+    }
+
+    // A vertex is still in the FIFO if fewer than VERTEX_CACHE_SIZE misses
+    // happened since it was pushed.
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    std::size_t misses = 0;
+
+    for (uint32_t index : indices)
+    {
+        if (time - timestamps[index] > VERTEX_CACHE_SIZE)
+        {
+            timestamps[index] = time++;
+            ++misses;
+        }
+    }
+
+    std::size_t usedVertices = 0;
+    for (uint32_t timestamp : timestamps)
+    {
+        usedVertices += timestamp != 0;
+    }
+
+    return VertexCacheStats{static_cast<float>(misses) / (indices.size() / 3),
+                            static_cast<float>(misses) / std::max<std::size_t>(usedVertices, 1)};
+}
+
+void OptimizeVertexCache(std::span<uint32_t> indices, std::size_t vertexCount)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    static const ScoreTables tables;
+
+    // Triangles adjacent to each vertex, stored contiguously. The first
+    // liveTriangles[v] entries of a vertex are the ones not emitted yet.
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : indices)
+    {
+        ++liveTriangles[index];
+    }
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        offsets[v + 1] = offsets[v] + liveTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<float> vertexScores(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScores[v] = VertexScore(tables, -1, liveTriangles[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (std::size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScores[t] =
+            vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    // The 3 new vertices are pushed in front of the LRU cache, the ones pushed
+    // past FORSYTH_CACHE_SIZE fall out.
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+    std::size_t cacheCount = 0;
+
+    std::size_t inputCursor = 0;
+    uint32_t bestTriangle =
+        std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+
+    while (output.size() < indices.size())
+    {
+        const uint32_t* triangle = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = true;
+        output.insert(output.end(), triangle, triangle + 3);
+
+        std::size_t newCount = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint32_t v = triangle[k];
+            newCache[newCount++] = v;
+
+            // Remove the triangle from the live list of the vertex.
+            uint32_t* begin = &adjacency[offsets[v]];
+            uint32_t* end = begin + liveTriangles[v];
+            *std::find(begin, end, bestTriangle) = end[-1];
+            --liveTriangles[v];
+        }
+        for (std::size_t i = 0; i < cacheCount; ++i)
+        {
+            const uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Update the score of every vertex that moved in or out of the cache and
+        // of their remaining triangles.
+        for (std::size_t i = 0; i < newCount; ++i)
+        {
+            const uint32_t v = newCache[i];
+            const int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+            const float delta = VertexScore(tables, position, liveTriangles[v]) - vertexScores[v];
+            vertexScores[v] += delta;
+
+            for (uint32_t j = 0; j < liveTriangles[v]; ++j)
+            {
+                triangleScores[adjacency[offsets[v] + j]] += delta;
+            }
+        }
+
+        // The next triangle is the best one touching the cache.
+        float bestScore = -1.0f;
+        for (std::size_t i = 0; i < std::min<std::size_t>(newCount, FORSYTH_CACHE_SIZE); ++i)
+        {
+            const uint32_t v = newCache[i];
+
+            for (uint32_t j = 0; j < liveTriangles[v]; ++j)
+            {
+                const uint32_t t = adjacency[offsets[v] + j];
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = std::min<std::size_t>(newCount, FORSYTH_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        // Dead end, nothing left around the cache: restart from the next triangle
+        // in input order rather than scanning the whole mesh.
+        if (bestScore < 0.0f && output.size() < indices.size())
+        {
+            while (emitted[inputCursor])
+            {
+                ++inputCursor;
+            }
+            bestTriangle = inputCursor;
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const float> vertices, std::size_t stride)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // A triangle with 3 cache misses starts a new strip, reordering at these
+    // points does not cost anything for the vertex cache.
+    std::vector<uint32_t> clusterStarts;
+    {
+        std::vector<uint32_t> timestamps(vertices.size() / stride, 0);
+        uint32_t time = VERTEX_CACHE_SIZE + 1;
+
+        for (std::size_t t = 0; t < triangleCount; ++t)
+        {
+            int misses = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t index = indices[t * 3 + k];
+                if (time - timestamps[index] > VERTEX_CACHE_SIZE)
+                {
+                    timestamps[index] = time++;
+                    ++misses;
+                }
+            }
+            if (t == 0 || misses == 3)
+            {
+                clusterStarts.push_back(t);
+            }
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    const std::size_t clusterCount = clusterStarts.size() - 1;
+
+    // Area weighted centroid and normal of every cluster, and of the whole mesh.
+    std::vector<Vector3> clusterCentroids(clusterCount);
+    std::vector<Vector3> clusterNormals(clusterCount);
+    Vector3 meshCentroid(0, 0, 0);
+    float meshArea = 0.0f;
+
+    for (std::size_t c = 0; c < clusterCount; ++c)
+    {
+        Vector3 centroid(0, 0, 0);
+        Vector3 normal(0, 0, 0);
+        float area = 0.0f;
+
+        for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            const Vector3 a = Position(vertices, stride, indices[t * 3]);
+            const Vector3 b = Position(vertices, stride, indices[t * 3 + 1]);
+            const Vector3 d = Position(vertices, stride, indices[t * 3 + 2]);
+
+            const Vector3 e1(b.x - a.x, b.y - a.y, b.z - a.z);
+            const Vector3 e2(d.x - a.x, d.y - a.y, d.z - a.z);
+            const Vector3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+            const float triangleArea = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+            centroid.x += (a.x + b.x + d.x) * triangleArea;
+            centroid.y += (a.y + b.y + d.y) * triangleArea;
+            centroid.z += (a.z + b.z + d.z) * triangleArea;
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += triangleArea;
+        }
+
+        meshCentroid.x += centroid.x;
+        meshCentroid.y += centroid.y;
+        meshCentroid.z += centroid.z;
+        meshArea += area;
+
+        const float scale = area > 0.0f ? 1.0f / (area * 3.0f) : 0.0f;
+        clusterCentroids[c] = Vector3(centroid.x * scale, centroid.y * scale, centroid.z * scale);
+        clusterNormals[c] = normal;
+    }
+
+    const float meshScale = meshArea > 0.0f ? 1.0f / (meshArea * 3.0f) : 0.0f;
+    meshCentroid = Vector3(meshCentroid.x * meshScale, meshCentroid.y * meshScale, meshCentroid.z * meshScale);
+
+    // Clusters far out along their normal are likely to hide the rest of the
+    // mesh, draw them first.
+    std::vector<float> sortKeys(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; ++c)
+    {
+        const Vector3& n = clusterNormals[c];
+        const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        const Vector3 offset(clusterCentroids[c].x - meshCentroid.x, clusterCentroids[c].y - meshCentroid.y,
+                             clusterCentroids[c].z - meshCentroid.z);
+
+        sortKeys[c] = length > 0.0f ? (offset.x * n.x + offset.y * n.y + offset.z * n.z) / length : 0.0f;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : order)
+    {
+        output.insert(output.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void OptimizeVertexFetch(std::vector<float>& vertices, std::size_t stride, std::span<uint32_t> indices)
+{
+    constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+
+    const std::size_t vertexCount = vertices.size() / stride;
+    std::vector<uint32_t> remap(vertexCount, UNUSED);
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+
+    uint32_t nextVertex = 0;
+
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = nextVertex++;
+            reordered.insert(reordered.end(), vertices.begin() + index * stride,
+                             vertices.begin() + (index + 1) * stride);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(reordered);
+}
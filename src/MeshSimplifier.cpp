@@ -0,0 +1,364 @@
+#include "MeshSimplifier.hpp"
+#include "math/vector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+
+// Sum of squared distances to a set of planes, stored as the upper half of a
+// symmetric 4x4 matrix.
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+
+    static Quadric FromPlane(double a, double b, double c, double d)
+    {
+        Quadric q;
+        q.a2 = a * a, q.ab = a * b, q.ac = a * c, q.ad = a * d;
+        q.b2 = b * b, q.bc = b * c, q.bd = b * d;
+        q.c2 = c * c, q.cd = c * d;
+        q.d2 = d * d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& o)
+    {
+        a2 += o.a2, ab += o.ab, ac += o.ac, ad += o.ad;
+        b2 += o.b2, bc += o.bc, bd += o.bd;
+        c2 += o.c2, cd += o.cd;
+        d2 += o.d2;
+        return *this;
+    }
+
+    double Evaluate(const Vector3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const double value = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x + b2 * y * y + 2 * bc * y * z +
+                             2 * bd * y + c2 * z * z + 2 * cd * z + d2;
+        // Rounding can make a perfect fit slightly negative.
+        return std::max(value, 0.0);
+    }
+};
+
+inline Vector3 Sub(const Vector3& a, const Vector3& b)
+{
+    return Vector3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+    return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline float Dot(const Vector3& a, const Vector3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Vertex -> triangles adjacency of a triangle list, stored contiguously.
+struct Adjacency
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    Adjacency(std::span<const uint32_t> indices, std::size_t vertexCount) : offsets(vertexCount + 1, 0)
+    {
+        for (uint32_t index : indices)
+        {
+            ++offsets[index + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        triangles.resize(indices.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            triangles[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::span<const uint32_t> Around(uint32_t vertex) const
+    {
+        return std::span<const uint32_t>(triangles.data() + offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+    }
+};
+
+// Lock vertices that share their position with another vertex (UV seams), and
+// vertices of edges that are not shared by exactly two opposite triangles
+// (borders and non-manifold edges).
+std::vector<bool> FindLockedVertices(std::span<const uint32_t> indices, const std::vector<Vector3>& positions)
+{
+    const std::size_t vertexCount = positions.size();
+    std::vector<bool> locked(vertexCount, false);
+
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    const auto less = [&](uint32_t a, uint32_t b) {
+        const Vector3& p = positions[a];
+        const Vector3& q = positions[b];
+        return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    for (std::size_t i = 1; i < vertexCount; ++i)
+    {
+        if (!less(order[i - 1], order[i]))
+        {
+            locked[order[i - 1]] = true;
+            locked[order[i]] = true;
+        }
+    }
+
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (std::size_t t = 0; t < indices.size(); t += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint64_t a = indices[t + k];
+            const uint64_t b = indices[t + (k + 1) % 3];
+            edges.push_back((a << 32) | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (std::size_t i = 0; i < edges.size(); ++i)
+    {
+        const uint64_t edge = edges[i];
+        const uint64_t reverse = (edge << 32) | (edge >> 32);
+        const auto range = std::equal_range(edges.begin(), edges.end(), reverse);
+        const bool duplicated = (i > 0 && edges[i - 1] == edge) || (i + 1 < edges.size() && edges[i + 1] == edge);
+
+        if (range.second - range.first != 1 || duplicated)
+        {
+            locked[edge >> 32] = true;
+            locked[edge & 0xffffffff] = true;
+        }
+    }
+
+    return locked;
+}
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    double cost;
+};
+
+// Moving `from` onto `to` must not flip a triangle around `from`, and the two
+// vertices must share exactly the neighbors of their common triangles, or the
+// surface would pinch.
+bool IsCollapseValid(const Collapse& collapse, std::span<const uint32_t> indices, const Adjacency& adjacency,
+                     const std::vector<Vector3>& positions, std::vector<uint32_t>& neighborScratch)
+{
+    const Vector3& target = positions[collapse.to];
+    std::size_t sharedTriangles = 0;
+
+    neighborScratch.clear();
+    for (uint32_t t : adjacency.Around(collapse.from))
+    {
+        const uint32_t* triangle = &indices[t * 3];
+
+        if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+        {
+            ++sharedTriangles;
+            continue;
+        }
+
+        const int k = triangle[0] == collapse.from ? 0 : triangle[1] == collapse.from ? 1 : 2;
+        const Vector3& p0 = positions[triangle[k]];
+        const Vector3& p1 = positions[triangle[(k + 1) % 3]];
+        const Vector3& p2 = positions[triangle[(k + 2) % 3]];
+
+        const Vector3 before = Cross(Sub(p1, p0), Sub(p2, p0));
+        const Vector3 after = Cross(Sub(p1, target), Sub(p2, target));
+        if (Dot(before, after) <= 0.0f)
+        {
+            return false;
+        }
+
+        neighborScratch.push_back(triangle[(k + 1) % 3]);
+        neighborScratch.push_back(triangle[(k + 2) % 3]);
+    }
+
+    std::sort(neighborScratch.begin(), neighborScratch.end());
+    neighborScratch.erase(std::unique(neighborScratch.begin(), neighborScratch.end()), neighborScratch.end());
+
+    std::size_t commonNeighbors = 0;
+    for (uint32_t t : adjacency.Around(collapse.to))
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint32_t v = indices[t * 3 + k];
+            if (v != collapse.to && v != collapse.from &&
+                std::binary_search(neighborScratch.begin(), neighborScratch.end(), v))
+            {
+                ++commonNeighbors;
+            }
+        }
+    }
+
+    // Each common neighbor is seen once per triangle around `to` it belongs to,
+    // twice on a closed fan. The opposite vertices of the shared triangles are
+    // the only ones allowed.
+    return commonNeighbors <= sharedTriangles * 2;
+}
+
+} // namespace
+
+std::vector<uint32_t> SimplifyMesh(std::span<const uint32_t> indices, std::span<const float> vertices,
+                                   std::size_t stride, std::size_t targetIndexCount, float& error)
+{
+    const std::size_t vertexCount = vertices.size() / stride;
+    std::vector<uint32_t> current(indices.begin(), indices.end());
+    error = 0.0f;
+
+    std::vector<Vector3> positions(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        positions[v] = Vector3(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]);
+    }
+
+    const std::vector<bool> locked = FindLockedVertices(current, positions);
+
+    // Each vertex starts with the planes of the triangles around it.
+    std::vector<Quadric> quadrics(vertexCount);
+    for (std::size_t t = 0; t < current.size(); t += 3)
+    {
+        const Vector3& p0 = positions[current[t]];
+        const Vector3& p1 = positions[current[t + 1]];
+        const Vector3& p2 = positions[current[t + 2]];
+        Vector3 n = Cross(Sub(p1, p0), Sub(p2, p0));
+        const float length = std::sqrt(Dot(n, n));
+
+        if (length == 0.0f)
+        {
+            continue;
+        }
+        n = Vector3(n.x / length, n.y / length, n.z / length);
+
+        const Quadric plane = Quadric::FromPlane(n.x, n.y, n.z, -Dot(n, p0));
+        for (int k = 0; k < 3; ++k)
+        {
+            quadrics[current[t + k]] += plane;
+        }
+    }
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> neighborScratch;
+    double maxCost = 0.0;
+
+    // Every pass collapses the cheapest independent edges, then rebuilds the
+    // connectivity, until the target is reached or nothing can move anymore.
+    while (current.size() > targetIndexCount)
+    {
+        const Adjacency adjacency(current, vertexCount);
+
+        // Best collapse of every free vertex onto one of its neighbors.
+        collapses.clear();
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            if (locked[v])
+            {
+                continue;
+            }
+
+            Collapse best{v, v, std::numeric_limits<double>::max()};
+            for (uint32_t t : adjacency.Around(v))
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    const uint32_t to = current[t * 3 + k];
+                    if (to == v)
+                    {
+                        continue;
+                    }
+                    Quadric sum = quadrics[v];
+                    sum += quadrics[to];
+                    const double cost = sum.Evaluate(positions[to]);
+                    if (cost < best.cost)
+                    {
+                        best = Collapse{v, to, cost};
+                    }
+                }
+            }
+            if (best.to != v)
+            {
+                collapses.push_back(best);
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+
+        const std::size_t trianglesToRemove = (current.size() - targetIndexCount) / 3 + 1;
+        std::size_t removed = 0;
+        std::size_t applied = 0;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (removed >= trianglesToRemove)
+            {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to] ||
+                !IsCollapseValid(collapse, current, adjacency, positions, neighborScratch))
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            maxCost = std::max(maxCost, collapse.cost);
+            ++applied;
+
+            // Freeze the whole neighborhood for this pass, the connectivity used
+            // to validate other collapses around it is now stale.
+            for (uint32_t t : adjacency.Around(collapse.from))
+            {
+                const uint32_t* triangle = &current[t * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    ++removed;
+                }
+            }
+        }
+
+        if (applied == 0)
+        {
+            break;
+        }
+
+        // Rewrite the triangles and drop the ones that became degenerate.
+        std::size_t write = 0;
+        for (std::size_t t = 0; t < current.size(); t += 3)
+        {
+            const uint32_t a = remap[current[t]];
+            const uint32_t b = remap[current[t + 1]];
+            const uint32_t c = remap[current[t + 2]];
+
+            if (a != b && b != c && a != c)
+            {
+                current[write++] = a;
+                current[write++] = b;
+                current[write++] = c;
+            }
+        }
+        current.resize(write);
+    }
+
+    error = static_cast<float>(std::sqrt(maxCost));
+    return current;
+}
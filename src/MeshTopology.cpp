@@ -0,0 +1,64 @@
+#include "MeshTopology.hpp"
+#include "ObjParser.hpp"
+#include <algorithm>
+
+std::vector<uint32_t> BuildPointIndices(std::span<const uint32_t> triangles, std::span<const IndexRange> ranges,
+                                        std::vector<IndexRange>& output)
+{
+    std::vector<uint32_t> points;
+    output.clear();
+    output.reserve(ranges.size());
+
+    for (const IndexRange& range : ranges)
+    {
+        const uint32_t offset = points.size();
+
+        // A closed mesh has about half as many vertices as triangles.
+        VertexTable seen(range.count / 6);
+
+        for (uint32_t i = range.offset; i < range.offset + range.count; ++i)
+        {
+            if (seen.Insert(triangles[i], 0).second)
+            {
+                points.push_back(triangles[i]);
+            }
+        }
+        output.push_back(IndexRange{offset, static_cast<uint32_t>(points.size() - offset)});
+    }
+    return points;
+}
+
+std::vector<uint32_t> BuildLineIndices(std::span<const uint32_t> triangles, std::span<const IndexRange> ranges,
+                                       std::vector<IndexRange>& output)
+{
+    std::vector<uint32_t> lines;
+    output.clear();
+    output.reserve(ranges.size());
+
+    for (const IndexRange& range : ranges)
+    {
+        const uint32_t offset = lines.size();
+
+        // And 3 edges for 2 triangles.
+        VertexTable seen(range.count / 2);
+
+        for (uint32_t i = range.offset; i + 2 < range.offset + range.count; i += 3)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t a = triangles[i + corner];
+                const uint32_t b = triangles[i + (corner + 1) % 3];
+                const uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+
+                // A degenerate edge draws nothing.
+                if (a != b && seen.Insert(key, 0).second)
+                {
+                    lines.push_back(a);
+                    lines.push_back(b);
+                }
+            }
+        }
+        output.push_back(IndexRange{offset, static_cast<uint32_t>(lines.size() - offset)});
+    }
+    return lines;
+}
@@ -1,96 +1,730 @@
 #include "Model.hpp"
-#include <fstream>
+#include "MappedFile.hpp"
+#include "MeshClusterizer.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshWelder.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
 #include <numeric>
-#include <sstream>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
-Model::Model(const std::string& filename)
-    : _vertices(), _verticesIndices(), _textureCoordinates(), _textureIndices(), _vertexBuffer(), _uniqueVertices(),
-      _triangleVertices(), _centroid(0, 0, 0)
+namespace
 {
 
-    _triangleVertices.reserve(3);
+// The vertices a range of indices uses, renumbered from 0 in the same order
+// as in the model, so passes break ties as they would on the whole model, with
+// a copy of their positions. Passes run on each part separately then
+// size their scratch by the part rather than by the whole model, which matters
+// for models of hundreds of parts.
+class LocalVertices
+{
+    public:
+    explicit LocalVertices(std::size_t vertexCount) : _localIds(vertexCount, NONE)
+    {
+    }
 
+    // Indices of the range in local ids.
+    std::vector<uint32_t> Compact(std::span<const uint32_t> indices, std::span<const float> vertices,
+                                  std::size_t stride)
+    {
+        for (const uint32_t vertex : _modelIds)
+        {
+            _localIds[vertex] = NONE;
+        }
+        _modelIds.clear();
+        _positions.clear();
+
+        for (const uint32_t vertex : indices)
+        {
+            if (_localIds[vertex] == NONE)
+            {
+                _localIds[vertex] = 0;
+                _modelIds.push_back(vertex);
+            }
+        }
+        std::sort(_modelIds.begin(), _modelIds.end());
+
+        _positions.reserve(_modelIds.size() * 3);
+        for (std::size_t i = 0; i < _modelIds.size(); ++i)
+        {
+            const std::size_t offset = static_cast<std::size_t>(_modelIds[i]) * stride;
+            _localIds[_modelIds[i]] = static_cast<uint32_t>(i);
+            _positions.insert(_positions.end(), {vertices[offset], vertices[offset + 1], vertices[offset + 2]});
+        }
+
+        std::vector<uint32_t> local(indices.size());
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            local[i] = _localIds[indices[i]];
+        }
+        return local;
+    }
+
+    // Local ids back to model ids, in place.
+    void Expand(std::span<uint32_t> indices) const
+    {
+        for (uint32_t& index : indices)
+        {
+            index = _modelIds[index];
+        }
+    }
+
+    // Positions only, 3 floats per vertex.
+    inline std::span<const float> GetPositions() const
+    {
+        return _positions;
+    }
+
+    inline std::size_t GetCount() const
+    {
+        return _modelIds.size();
+    }
+
+    private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> _localIds;
+    std::vector<uint32_t> _modelIds;
+    std::vector<float> _positions;
+};
+
+} // namespace
+
+Model::Model()
+    : _vertices(), _verticesIndices(), _textureCoordinates(), _textureIndices(), _vertexBuffer(), _centroid(0, 0, 0),
+      _boundsMin(0, 0, 0), _boundsMax(0, 0, 0), _sphereCenter(0, 0, 0), _sphereRadius(0.0f), _lods(), _meshlets(),
+      _submeshes(), _submeshRanges(), _submeshStrings(), _materialLibraries(), _materials(), _submeshMaterials(),
+      _bvhThreadCount(0), _cache()
+{
+}
+
+Model::Model(const std::string& filename, const ModelLoadOptions& options) : Model()
+{
     if (filename.find(".obj") == std::string::npos)
     {
         throw std::runtime_error("Error: file is not an obj.");
     }
 
-    std::ifstream infile(filename);
+    const MappedFile file(filename);
+    MeshCacheKey key{};
+
+    if (options.useCache)
+    {
+        key = MeshCache::MakeKey(filename, file);
+
+        if (LoadCache(filename, key, GetCacheFlags(options)))
+        {
+            Complete(filename, options);
+            return;
+        }
+    }
+
+    const std::vector<ObjRun> runs = Parse(file, options.threadCount);
+    Finish(filename, options, key, runs);
+    Complete(filename, options);
+}
 
-    if (!infile.is_open())
+uint32_t Model::GetCacheFlags(const ModelLoadOptions& options)
+{
+    return (options.optimize ? MESH_CACHE_OPTIMIZED : 0) | (options.generateLods ? MESH_CACHE_LODS : 0) |
+           (options.buildMeshlets ? MESH_CACHE_MESHLETS : 0) | (options.weld ? MESH_CACHE_WELDED : 0);
+}
+
+bool Model::LoadCache(const std::string& filename, const MeshCacheKey& key, uint32_t flags)
+{
+    _cache = MeshCache::Open(filename, key, flags);
+
+    if (!_cache)
     {
-        const std::string error = "Error: Cannot open file: " + filename;
-        throw std::runtime_error(error);
+        return false;
     }
 
-    std::string line, type;
-    std::size_t start = 0;
+    const MeshCacheHeader& header = _cache->GetHeader();
+    _centroid = header.centroid;
+    _boundsMin = header.boundsMin;
+    _boundsMax = header.boundsMax;
+    _sphereCenter = header.sphereCenter;
+    _sphereRadius = header.sphereRadius;
+    const std::span<const MeshLod> lods = _cache->GetLods();
+    _lods.assign(lods.begin(), lods.end());
+    const std::span<const Meshlet> meshlets = _cache->GetMeshlets();
+    _meshlets.assign(meshlets.begin(), meshlets.end());
+    const std::span<const Submesh> submeshes = _cache->GetSubmeshes();
+    _submeshes.assign(submeshes.begin(), submeshes.end());
+    const std::span<const MeshRange> ranges = _cache->GetSubmeshRanges();
+    _submeshRanges.assign(ranges.begin(), ranges.end());
+    _submeshStrings = _cache->GetSubmeshStrings();
+
+    std::string_view libraries = _cache->GetMaterialLibraries();
+    while (!libraries.empty())
+    {
+        const std::size_t newline = libraries.find('\n');
+        _materialLibraries.emplace_back(libraries.substr(0, newline));
+        libraries.remove_prefix(newline + 1);
+    }
+    return true;
+}
+
+void Model::Finish(const std::string& filename, const ModelLoadOptions& options, const MeshCacheKey& key,
+                   const std::vector<ObjRun>& runs)
+{
+    CalculateCentroid();
+    CalculateBounds();
+    CalculateBoundingSphere();
+
+    // Only needed while parsing, the vertex buffer holds the same data.
+    _vertices = {};
+    _textureCoordinates = {};
+    _textureIndices = {};
 
-    while (std::getline(infile, line))
+    BuildSubmeshes(runs);
+
+    // Before the split, which would otherwise merge back the copies it makes.
+    if (options.weld)
     {
-        start = line.find(" ");
-        type = line.substr(0, start);
+        Weld(filename);
+    }
+
+    SplitVerticesByMaterial();
 
-        if (type == "v" || type == "vt")
+    if (options.optimize)
+    {
+        Optimize(filename);
+    }
+
+    _lods.push_back(MeshLod{0, static_cast<uint32_t>(_verticesIndices.size()), 0.0f, 0, 0});
+
+    if (options.generateLods)
+    {
+        GenerateLods(filename, options.optimize);
+    }
+
+    if (options.buildMeshlets)
+    {
+        GenerateMeshlets(filename);
+    }
+
+    CalculateSubmeshBounds();
+
+    if (options.useCache)
+    {
+        MeshCache::Write(filename, key, GetCacheFlags(options), *this);
+    }
+}
+
+void Model::Complete(const std::string& filename, const ModelLoadOptions& options)
+{
+    LoadMaterials(filename);
+    _bvhThreadCount = options.buildBvh ? std::max<uint32_t>(options.threadCount, 1) : 0;
+}
+
+void Model::BuildSubmeshes(const std::vector<ObjRun>& runs)
+{
+    const uint32_t triangleCount = _verticesIndices.size() / 3;
+
+    // Runs sharing a name and a material form one submesh, in the order they
+    // first appear in the file.
+    std::unordered_map<std::string, uint32_t> submeshOf;
+    std::vector<uint32_t> runSubmesh(runs.size());
+
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        const std::string& name = *runs[i].name;
+        const std::string& material = *runs[i].material;
+        const auto [it, inserted] = submeshOf.try_emplace(name + '\n' + material, _submeshes.size());
+
+        if (inserted)
         {
-            std::istringstream iss(line.substr(start + 1));
-            std::vector<float> values;
-            float value;
+            Submesh submesh{};
+            submesh.nameOffset = _submeshStrings.size();
+            submesh.nameLength = name.size();
+            _submeshStrings += name;
+            submesh.materialOffset = _submeshStrings.size();
+            submesh.materialLength = material.size();
+            _submeshStrings += material;
+            _submeshes.push_back(submesh);
+        }
+        runSubmesh[i] = it->second;
+    }
 
-            while (iss >> value)
-            {
-                values.push_back(value);
-            }
+    if (_submeshes.empty())
+    {
+        _submeshes.push_back(Submesh{});
+    }
 
-            if (type == "v")
+    // Submeshes of the same material follow each other, so they end up in
+    // neighboring ranges the renderer can draw together.
+    std::unordered_map<std::string_view, uint32_t> materialRank;
+    std::vector<uint32_t> order(_submeshes.size());
+    for (std::size_t s = 0; s < _submeshes.size(); ++s)
+    {
+        materialRank.try_emplace(GetSubmeshMaterial(s), materialRank.size());
+        order[s] = s;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return materialRank[GetSubmeshMaterial(a)] < materialRank[GetSubmeshMaterial(b)];
+    });
+
+    std::vector<uint32_t> position(order.size());
+    std::vector<Submesh> sorted(order.size());
+    for (std::size_t s = 0; s < order.size(); ++s)
+    {
+        position[order[s]] = s;
+        sorted[s] = _submeshes[order[s]];
+    }
+    _submeshes = std::move(sorted);
+    for (uint32_t& submesh : runSubmesh)
+    {
+        submesh = position[submesh];
+    }
+
+    const auto runEnd = [&](std::size_t i) {
+        return i + 1 < runs.size() ? runs[i + 1].firstTriangle : triangleCount;
+    };
+
+    _submeshRanges.assign(_submeshes.size(), MeshRange{0, 0, 0, 0});
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        _submeshRanges[runSubmesh[i]].indexCount += (runEnd(i) - runs[i].firstTriangle) * 3;
+    }
+
+    uint32_t offset = 0;
+    for (MeshRange& range : _submeshRanges)
+    {
+        range.indexOffset = offset;
+        offset += range.indexCount;
+    }
+
+    // A file with a single part, or parts already grouped, keeps its order.
+    if (std::is_sorted(runSubmesh.begin(), runSubmesh.end()))
+    {
+        return;
+    }
+
+    std::vector<uint32_t> indices(_verticesIndices.size());
+    std::vector<uint32_t> cursor(_submeshes.size());
+    for (std::size_t s = 0; s < cursor.size(); ++s)
+    {
+        cursor[s] = _submeshRanges[s].indexOffset;
+    }
+
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        const uint32_t begin = runs[i].firstTriangle * 3;
+        const uint32_t end = runEnd(i) * 3;
+        std::copy(_verticesIndices.begin() + begin, _verticesIndices.begin() + end,
+                  indices.begin() + cursor[runSubmesh[i]]);
+        cursor[runSubmesh[i]] += end - begin;
+    }
+    _verticesIndices = std::move(indices);
+}
+
+void Model::Weld(const std::string& filename)
+{
+    const float extent =
+        std::max({_boundsMax.x - _boundsMin.x, _boundsMax.y - _boundsMin.y, _boundsMax.z - _boundsMin.z});
+
+    if (extent <= 0.0f)
+    {
+        return;
+    }
+
+    const std::size_t before = _vertexBuffer.size() / 5;
+    const std::size_t after =
+        WeldVertices(_vertexBuffer, 5, _verticesIndices, extent * WELD_POSITION_TOLERANCE, WELD_UV_TOLERANCE);
+
+    // Triangles with merged corners cover no pixel, each submesh range shrinks
+    // and moves down over the ones removed before it.
+    const std::size_t indexCount = _verticesIndices.size();
+    uint32_t written = 0;
+    for (MeshRange& range : _submeshRanges)
+    {
+        const std::span<uint32_t> indices(_verticesIndices.data() + range.indexOffset, range.indexCount);
+        const uint32_t count = RemoveDegenerateTriangles(indices);
+
+        if (written != range.indexOffset)
+        {
+            std::copy(indices.begin(), indices.begin() + count, _verticesIndices.begin() + written);
+        }
+        range.indexOffset = written;
+        range.indexCount = count;
+        written += count;
+    }
+    _verticesIndices.resize(written);
+
+    std::cout << "Welded " << filename << ": " << before << " -> " << after << " vertices ("
+              << (before > 0 ? 100.0 * (before - after) / before : 0.0) << "% fewer), "
+              << (indexCount - written) / 3 << " collapsed triangles removed\n";
+}
+
+void Model::SplitVerticesByMaterial()
+{
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    // The renderer gives each vertex the texture layer of its material, a
+    // vertex on the border of two materials needs one copy per material.
+    std::unordered_map<std::string_view, uint32_t> materialIds;
+    std::vector<uint32_t> materialOf(_vertexBuffer.size() / 5, NONE);
+    std::unordered_map<uint64_t, uint32_t> copies;
+
+    for (std::size_t s = 0; s < _submeshes.size(); ++s)
+    {
+        const uint32_t material = materialIds.try_emplace(GetSubmeshMaterial(s), materialIds.size()).first->second;
+        const MeshRange& range = _submeshRanges[s];
+
+        for (uint32_t i = range.indexOffset; i < range.indexOffset + range.indexCount; ++i)
+        {
+            const uint32_t vertex = _verticesIndices[i];
+
+            if (materialOf[vertex] == NONE)
             {
-                const Vector3 vec3(values[0], values[1], values[2]);
-                _vertices.push_back(vec3);
+                materialOf[vertex] = material;
             }
-            else
+            else if (materialOf[vertex] != material)
             {
-                // Subtract 1 to adapt the texture origin to the top-left corner.
-                const Vector2 vec2(values[0], 1.0 - values[1]);
-                _textureCoordinates.push_back(vec2);
+                const uint64_t key = (static_cast<uint64_t>(vertex) << 32) | material;
+                const auto [it, inserted] = copies.try_emplace(key, materialOf.size());
+
+                if (inserted)
+                {
+                    // Copied out first, inserting a range of the vector into
+                    // itself is undefined once it reallocates.
+                    const std::size_t offset = static_cast<std::size_t>(vertex) * 5;
+                    std::array<float, 5> copy;
+                    std::copy_n(_vertexBuffer.begin() + offset, copy.size(), copy.begin());
+                    _vertexBuffer.insert(_vertexBuffer.end(), copy.begin(), copy.end());
+                    materialOf.push_back(material);
+                }
+                _verticesIndices[i] = it->second;
             }
         }
+    }
+}
+
+void Model::LoadMaterials(const std::string& filename)
+{
+    const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+
+    for (std::size_t i = 0; i < _materialLibraries.size(); ++i)
+    {
+        const std::string& library = _materialLibraries[i];
+        const std::string path = (directory / library).string();
+
+        if (std::find(_materialLibraries.begin(), _materialLibraries.begin() + i, library) !=
+            _materialLibraries.begin() + i)
+        {
+            continue;
+        }
+        if (!std::filesystem::exists(path))
+        {
+            std::cerr << "Warning: material library not found: " << path << "\n";
+            continue;
+        }
+        LoadMaterialLibrary(path, _materials);
+    }
+
+    _submeshMaterials.assign(_submeshes.size(), NO_MATERIAL);
+    for (std::size_t s = 0; s < _submeshes.size(); ++s)
+    {
+        const std::string_view name = GetSubmeshMaterial(s);
+        const auto material = std::find_if(_materials.begin(), _materials.end(),
+                                           [&](const Material& m) { return m.name == name; });
 
-        else if (type == "f")
+        if (material != _materials.end())
         {
-            // At this state, we have parsed all vertices and texture coordinates. So
-            // if the container is empty, it means we should calculate texture
-            // coordinates.
-            if (_textureCoordinates.empty())
-            {
-                CalculateTextureCoordinates();
-            }
+            _submeshMaterials[s] = material - _materials.begin();
+        }
+        else if (!name.empty() && !_materials.empty())
+        {
+            std::cerr << "Warning: unknown material " << name << " in " << filename << "\n";
+        }
+    }
+}
+
+void Model::CalculateSubmeshBounds()
+{
+    const std::span<const float> vertices = GetVertexData();
+    const std::span<const uint32_t> indices = GetIndexData();
+
+    for (std::size_t s = 0; s < _submeshes.size(); ++s)
+    {
+        const MeshRange& range = GetSubmeshRange(0, s);
+        Submesh& submesh = _submeshes[s];
+
+        if (range.indexCount == 0)
+        {
+            submesh.boundsMin = _boundsMin;
+            submesh.boundsMax = _boundsMax;
+            continue;
+        }
 
-            std::istringstream iss(line.substr(start + 1));
-            std::vector<std::string> vertices;
-            std::string vertex;
+        const float* first = &vertices[indices[range.indexOffset] * 5];
+        Vector3 min(first[0], first[1], first[2]);
+        Vector3 max = min;
 
-            // Split each vertex in a string.
-            // Ex: f 1/1/1 5/2/1 7/3/1 3/4/1 -> vertices[0] = 1/1/1.
-            while (iss >> vertex)
+        for (uint32_t i = range.indexOffset; i < range.indexOffset + range.indexCount; ++i)
+        {
+            const float* p = &vertices[indices[i] * 5];
+            min = Vector3(std::min(min.x, p[0]), std::min(min.y, p[1]), std::min(min.z, p[2]));
+            max = Vector3(std::max(max.x, p[0]), std::max(max.y, p[1]), std::max(max.z, p[2]));
+        }
+        submesh.boundsMin = min;
+        submesh.boundsMax = max;
+    }
+}
+
+void Model::Optimize(const std::string& filename)
+{
+    const std::size_t vertexCount = _vertexBuffer.size() / 5;
+    const VertexCacheStats before = AnalyzeVertexCache(_verticesIndices, vertexCount);
+
+    // Triangles never leave their submesh, each range is optimized on its own.
+    LocalVertices local(vertexCount);
+    for (const MeshRange& range : _submeshRanges)
+    {
+        const std::span<uint32_t> indices(_verticesIndices.data() + range.indexOffset, range.indexCount);
+        std::vector<uint32_t> localIndices = local.Compact(indices, _vertexBuffer, 5);
+        OptimizeVertexCache(localIndices, local.GetCount());
+        OptimizeOverdraw(localIndices, local.GetPositions(), 3);
+        local.Expand(localIndices);
+        std::copy(localIndices.begin(), localIndices.end(), indices.begin());
+    }
+    OptimizeVertexFetch(_vertexBuffer, 5, _verticesIndices);
+
+    const VertexCacheStats after = AnalyzeVertexCache(_verticesIndices, vertexCount);
+
+    std::cout << "Optimized " << filename << ": ACMR " << before.acmr << " -> " << after.acmr << ", ATVR "
+              << before.atvr << " -> " << after.atvr << "\n";
+}
+
+void Model::GenerateLods(const std::string& filename, bool optimize)
+{
+    const std::size_t vertexCount = _vertexBuffer.size() / 5;
+    const std::size_t submeshCount = _submeshes.size();
+    LocalVertices local(vertexCount);
+    float error = 0.0f;
+
+    // Each level is simplified from the previous one rather than from the full
+    // mesh, which is much cheaper and gives nested levels. Submeshes are
+    // simplified separately, so their borders stay in place.
+    for (uint32_t level = 1; level <= MAX_LOD_COUNT; ++level)
+    {
+        const MeshLod& previous = _lods.back();
+        const uint32_t levelOffset = _verticesIndices.size();
+        std::vector<uint32_t> levelIndices;
+        std::vector<MeshRange> levelRanges;
+        float levelError = 0.0f;
+
+        for (std::size_t s = 0; s < submeshCount; ++s)
+        {
+            const MeshRange& range = GetSubmeshRange(level - 1, s);
+            const std::span<const uint32_t> indices(_verticesIndices.data() + range.indexOffset, range.indexCount);
+            const std::vector<uint32_t> localIndices = local.Compact(indices, _vertexBuffer, 5);
+            float submeshError = 0.0f;
+            std::vector<uint32_t> simplified =
+                SimplifyMesh(localIndices, local.GetPositions(), 3, range.indexCount / 6 * 3, submeshError);
+
+            if (optimize)
             {
-                vertices.push_back(vertex);
+                OptimizeVertexCache(simplified, local.GetCount());
             }
-            if (vertices.size() == 3)
+            local.Expand(simplified);
+
+            levelRanges.push_back(MeshRange{static_cast<uint32_t>(levelOffset + levelIndices.size()),
+                                            static_cast<uint32_t>(simplified.size()), 0, 0});
+            levelIndices.insert(levelIndices.end(), simplified.begin(), simplified.end());
+            levelError = std::max(levelError, submeshError);
+        }
+
+        if (levelIndices.empty() || levelIndices.size() > previous.indexCount * MIN_LOD_REDUCTION)
+        {
+            break;
+        }
+
+        error = std::max(error, levelError);
+        _lods.push_back(MeshLod{levelOffset, static_cast<uint32_t>(levelIndices.size()), error, 0, 0});
+        _verticesIndices.insert(_verticesIndices.end(), levelIndices.begin(), levelIndices.end());
+        _submeshRanges.insert(_submeshRanges.end(), levelRanges.begin(), levelRanges.end());
+    }
+
+    std::cout << "Generated " << _lods.size() - 1 << " levels of detail for " << filename << ":";
+    for (const MeshLod& lod : _lods)
+    {
+        std::cout << " " << lod.indexCount / 3;
+    }
+    std::cout << " triangles\n";
+}
+
+void Model::GenerateMeshlets(const std::string& filename)
+{
+    for (std::size_t level = 0; level < _lods.size(); ++level)
+    {
+        MeshLod& lod = _lods[level];
+        lod.meshletOffset = _meshlets.size();
+
+        for (std::size_t s = 0; s < _submeshes.size(); ++s)
+        {
+            MeshRange& range = _submeshRanges[level * _submeshes.size() + s];
+            const std::span<uint32_t> indices(_verticesIndices.data() + range.indexOffset, range.indexCount);
+            const std::vector<Meshlet> meshlets = BuildMeshlets(indices, _vertexBuffer, 5);
+
+            range.meshletOffset = _meshlets.size();
+            range.meshletCount = meshlets.size();
+
+            for (Meshlet meshlet : meshlets)
             {
-                CreateFaces(vertices);
+                meshlet.indexOffset += range.indexOffset;
+                _meshlets.push_back(meshlet);
             }
+        }
+        lod.meshletCount = _meshlets.size() - lod.meshletOffset;
+    }
+
+    std::cout << "Built " << _lods[0].meshletCount << " meshlets for " << filename << " (" << _meshlets.size()
+              << " with every level of detail)\n";
+}
 
-            else if (vertices.size() > 3)
+std::vector<ObjRun> Model::Parse(const MappedFile& file, uint32_t threadCount)
+{
+    const char* begin = file.GetData();
+    const char* end = begin + file.GetSize();
+
+    // Below a few megabytes, spawning threads costs more than it saves.
+    const std::size_t chunkCount =
+        std::clamp<std::size_t>(file.GetSize() / MIN_CHUNK_SIZE, 1, std::max<uint32_t>(threadCount, 1));
+    const std::vector<const char*> bounds = SplitObjInLines(begin, end, chunkCount);
+
+    std::vector<ObjChunk> chunks(chunkCount);
+
+    if (chunkCount == 1)
+    {
+        ParseObjChunk(begin, end, chunks[0]);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        std::vector<std::exception_ptr> errors(chunkCount);
+
+        workers.reserve(chunkCount);
+        for (std::size_t i = 0; i < chunkCount; ++i)
+        {
+            workers.emplace_back([&, i]() {
+                try
+                {
+                    ParseObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+
+        // Report the error of the earliest chunk, as the serial parser would.
+        for (const std::exception_ptr& error : errors)
+        {
+            if (error)
             {
-                TriangulateFaces(vertices);
+                std::rethrow_exception(error);
             }
         }
     }
 
-    CalculateCentroid();
+    return MergeChunks(chunks);
+}
+
+std::vector<ObjRun> Model::MergeChunks(std::vector<ObjChunk>& chunks)
+{
+    // Resolved before the triangles are moved out of the chunks.
+    std::string name;
+    std::string material;
+    const std::vector<ObjRun> runs = ResolveObjRuns(chunks, name, material);
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        _materialLibraries.insert(_materialLibraries.end(), chunk.materialLibraries.begin(),
+                                  chunk.materialLibraries.end());
+    }
+
+    // Faces written without texture coordinates use generated ones. The serial
+    // parser decides it at the first face line of the file, from the vertices
+    // declared above it, so find that line across the chunks.
+    std::size_t vertexOffset = 0;
+    std::size_t textureOffset = 0;
+    std::size_t generatedCount = 0;
+    bool generate = false;
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (chunk.hasFace)
+        {
+            generate = textureOffset + chunk.firstFaceTextureCount == 0;
+            generatedCount = vertexOffset + chunk.firstFaceVertexCount;
+            break;
+        }
+        vertexOffset += chunk.vertices.size();
+        textureOffset += chunk.textureCoordinates.size();
+    }
+
+    std::size_t vertexCount = 0;
+    std::size_t textureCount = 0;
+    std::size_t cornerCount = 0;
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        vertexCount += chunk.vertices.size();
+        textureCount += chunk.textureCoordinates.size();
+        cornerCount += chunk.triangles.size();
+    }
+
+    std::vector<FaceCorner> triangles;
+
+    // A single chunk is moved as is, several ones are concatenated in file order.
+    if (chunks.size() == 1)
+    {
+        _vertices = std::move(chunks[0].vertices);
+        triangles = std::move(chunks[0].triangles);
+    }
+    else
+    {
+        _vertices.reserve(vertexCount);
+        triangles.reserve(cornerCount);
+        for (ObjChunk& chunk : chunks)
+        {
+            _vertices.insert(_vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+            triangles.insert(triangles.end(), chunk.triangles.begin(), chunk.triangles.end());
+            chunk.vertices = {};
+            chunk.triangles = {};
+        }
+    }
+
+    _textureCoordinates.reserve((generate ? generatedCount : 0) + textureCount);
+    if (generate)
+    {
+        CalculateTextureCoordinates(generatedCount);
+    }
+    for (ObjChunk& chunk : chunks)
+    {
+        _textureCoordinates.insert(_textureCoordinates.end(), chunk.textureCoordinates.begin(),
+                                   chunk.textureCoordinates.end());
+        chunk.textureCoordinates = {};
+    }
+
+    CreateFaces(triangles);
+    return runs;
 }
 
 void Model::CalculateCentroid()
@@ -108,11 +742,120 @@ void Model::CalculateCentroid()
     _centroid = Vector3(sum.x / _vertices.size(), sum.y / _vertices.size(), sum.z / _vertices.size());
 }
 
-// https://community.khronos.org/t/calc-texture-coordinate/14707/5
+void Model::CalculateBounds()
+{
+    if (_vertices.empty())
+    {
+        _boundsMin = Vector3(0, 0, 0);
+        _boundsMax = Vector3(0, 0, 0);
+        return;
+    }
 
-void Model::CalculateTextureCoordinates()
+    _boundsMin = _vertices[0];
+    _boundsMax = _vertices[0];
+
+    for (const Vector3& vertex : _vertices)
+    {
+        _boundsMin = Vector3(std::min(_boundsMin.x, vertex.x), std::min(_boundsMin.y, vertex.y),
+                             std::min(_boundsMin.z, vertex.z));
+        _boundsMax = Vector3(std::max(_boundsMax.x, vertex.x), std::max(_boundsMax.y, vertex.y),
+                             std::max(_boundsMax.z, vertex.z));
+    }
+}
+
+void Model::CalculateBoundingSphere()
 {
     if (_vertices.empty())
+    {
+        _sphereCenter = Vector3(0, 0, 0);
+        _sphereRadius = 0.0f;
+        return;
+    }
+
+    const auto distanceSquared = [](const Vector3& a, const Vector3& b) {
+        const float dx = a.x - b.x;
+        const float dy = a.y - b.y;
+        const float dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    };
+    const auto farthest = [&](const Vector3& from) {
+        return *std::max_element(_vertices.begin(), _vertices.end(), [&](const Vector3& a, const Vector3& b) {
+            return distanceSquared(from, a) < distanceSquared(from, b);
+        });
+    };
+
+    // Start from two far apart points, then grow the sphere just enough for
+    // every point left outside.
+    const Vector3 a = farthest(_vertices[0]);
+    const Vector3 b = farthest(a);
+    Vector3 center((a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f);
+    float radius = std::sqrt(distanceSquared(a, b)) * 0.5f;
+
+    for (const Vector3& vertex : _vertices)
+    {
+        const float distance = std::sqrt(distanceSquared(center, vertex));
+
+        if (distance > radius)
+        {
+            const float newRadius = (radius + distance) * 0.5f;
+            const float shift = (newRadius - radius) / distance;
+            center = Vector3(center.x + (vertex.x - center.x) * shift, center.y + (vertex.y - center.y) * shift,
+                             center.z + (vertex.z - center.z) * shift);
+            radius = newRadius;
+        }
+    }
+
+    _sphereCenter = center;
+    _sphereRadius = radius;
+}
+
+std::span<const float> Model::GetVertexData() const
+{
+    return _cache ? _cache->GetVertices() : std::span<const float>(_vertexBuffer);
+}
+
+std::span<const uint32_t> Model::GetIndexData() const
+{
+    return _cache ? _cache->GetIndices() : std::span<const uint32_t>(_verticesIndices);
+}
+
+std::span<const MeshLod> Model::GetLods() const
+{
+    return _lods;
+}
+
+std::span<const Meshlet> Model::GetMeshlets() const
+{
+    return _meshlets;
+}
+
+std::span<const Submesh> Model::GetSubmeshes() const
+{
+    return _submeshes;
+}
+
+const MeshRange& Model::GetSubmeshRange(std::size_t level, std::size_t submesh) const
+{
+    return _submeshRanges[level * _submeshes.size() + submesh];
+}
+
+std::string_view Model::GetSubmeshName(std::size_t submesh) const
+{
+    const Submesh& s = _submeshes[submesh];
+    return std::string_view(_submeshStrings).substr(s.nameOffset, s.nameLength);
+}
+
+std::string_view Model::GetSubmeshMaterial(std::size_t submesh) const
+{
+    const Submesh& s = _submeshes[submesh];
+    return std::string_view(_submeshStrings).substr(s.materialOffset, s.materialLength);
+}
+
+// https://community.khronos.org/t/calc-texture-coordinate/14707/5
+
+void Model::CalculateTextureCoordinates(std::size_t vertexCount)
+{
+    if (vertexCount == 0)
     {
         throw std::runtime_error("Error: no vertices found in obj.");
     }
@@ -122,55 +865,51 @@ void Model::CalculateTextureCoordinates()
     float minY = std::numeric_limits<float>::max();
     float maxY = std::numeric_limits<float>::lowest();
 
-    for (const Vector3& vertex : _vertices)
+    for (std::size_t i = 0; i < vertexCount; ++i)
     {
+        const Vector3& vertex = _vertices[i];
         minX = std::min(minX, vertex.x);
         maxX = std::max(maxX, vertex.x);
         minY = std::min(minY, vertex.y);
         maxY = std::max(maxY, vertex.y);
     }
 
-    for (size_t i = 0; i < _vertices.size(); i += 3)
-    {
-        const Vector3& vertex0 = _vertices[i];
-        const Vector3& vertex1 = _vertices[i + 1];
-        const Vector3& vertex2 = _vertices[i + 2];
-
-        const Vector2 uv0((vertex0.x - minX) / (maxX - minX), (vertex0.y - minY) / (maxY - minY));
-        const Vector2 uv1((vertex1.x - minX) / (maxX - minX), (vertex1.y - minY) / (maxY - minY));
-        const Vector2 uv2((vertex2.x - minX) / (maxX - minX), (vertex2.y - minY) / (maxY - minY));
+    _textureIndices.reserve(vertexCount);
 
-        _textureCoordinates.push_back(uv0);
-        _textureCoordinates.push_back(uv1);
-        _textureCoordinates.push_back(uv2);
-    }
-
-    for (size_t i = 0; i < _vertices.size(); i++)
+    for (std::size_t i = 0; i < vertexCount; ++i)
     {
+        const Vector3& vertex = _vertices[i];
+        _textureCoordinates.emplace_back((vertex.x - minX) / (maxX - minX), (vertex.y - minY) / (maxY - minY));
         _textureIndices.push_back(i);
     }
 }
 
-void Model::CreateFaces(const std::vector<std::string>& vertices)
+void Model::CreateFaces(const std::vector<FaceCorner>& corners)
+{
+    // Most corners share both their position and their texture coordinate, the
+    // number of unique vertices is close to the largest of the two pools.
+    _vertexBuffer.reserve(std::max(_vertices.size(), _textureCoordinates.size()) * 5);
+    _verticesIndices.reserve(corners.size());
+
+    // Only lives while the buffers are built, the memory is released on return.
+    VertexTable uniqueVertices(corners.size() / 3);
+
+    AppendFaces(corners, uniqueVertices);
+}
+
+void Model::AppendFaces(std::span<const FaceCorner> corners, VertexTable& uniqueVertices)
 {
-    for (const auto& triangleVertex : vertices)
+    for (const FaceCorner& corner : corners)
     {
-        std::istringstream vertexStream(triangleVertex);
-        std::string index;
-        unsigned int vertexIndex = 0, textureIndex = 0;
+        const uint32_t vertexIndex = corner.vertexIndex;
+        uint32_t textureIndex = corner.textureIndex;
 
-        // Parse vertices indices. (first /)
-        if (std::getline(vertexStream, index, '/') && !index.empty())
+        if (vertexIndex >= _vertices.size())
         {
-            vertexIndex = std::stoul(index) - 1;
+            throw std::runtime_error("Error: Vertex index out of bounds");
         }
 
-        // Parse texture coordinates indices. (second /)
-        if (std::getline(vertexStream, index, '/') && !index.empty())
-        {
-            textureIndex = std::stoul(index) - 1;
-        }
-        else
+        if (textureIndex == NO_TEXTURE_INDEX)
         {
             // Protect the case that face is parsed but indices is not in file.
             if (vertexIndex >= _textureIndices.size())
@@ -179,13 +918,17 @@ void Model::CreateFaces(const std::vector<std::string>& vertices)
             }
             textureIndex = _textureIndices[vertexIndex];
         }
+        else if (textureIndex >= _textureCoordinates.size())
+        {
+            throw std::runtime_error("Error: Texture index out of bounds");
+        }
 
-        // Generate a unique key for the vertex-texture combination.
-        const std::string key = std::to_string(vertexIndex) + "/" + std::to_string(textureIndex);
+        // Pack the vertex-texture combination in a single integer key.
+        const uint64_t key = (static_cast<uint64_t>(vertexIndex) << 32) | textureIndex;
+        const auto [index, inserted] = uniqueVertices.Insert(key, _vertexBuffer.size() / 5);
 
-        if (_uniqueVertices.find(key) == _uniqueVertices.end())
+        if (inserted)
         {
-
             // Retrieve the vertices corresponding to vertices index found in face.
             const Vector3& vertex = _vertices[vertexIndex];
             _vertexBuffer.push_back(vertex.x);
@@ -197,33 +940,19 @@ void Model::CreateFaces(const std::vector<std::string>& vertices)
             const Vector2& texCoord = _textureCoordinates[textureIndex];
             _vertexBuffer.push_back(texCoord.u);
             _vertexBuffer.push_back(texCoord.v);
-
-            // Store the index of the new vertex by calculating last vertex index.
-            // Since a contain 5 float, we divide per 5 to know how many vertex are in
-            // there.
-            // - 1 for finding the new index.
-            _uniqueVertices[key] = _vertexBuffer.size() / 5 - 1;
         }
 
         // Store the new indices that will be used in Vertex Buffer.
-        _verticesIndices.push_back(_uniqueVertices[key]);
+        _verticesIndices.push_back(index);
     }
 }
 
-void Model::TriangulateFaces(const std::vector<std::string>& verticesString)
+std::span<const Material> Model::GetMaterials() const
 {
+    return _materials;
+}
 
-    for (unsigned int i = 1; i < verticesString.size() - 1; ++i)
-    {
-        _triangleVertices.clear();
-
-        // emplace_back is more memory-efficient than push_back because it moves the
-        // object instead of copying it. https://www.youtube.com/watch?v=HcESuwmlHEY
-
-        _triangleVertices.emplace_back(verticesString[0]);
-        _triangleVertices.emplace_back(verticesString[i]);
-        _triangleVertices.emplace_back(verticesString[i + 1]);
-
-        CreateFaces(_triangleVertices);
-    }
+uint32_t Model::GetSubmeshMaterialIndex(std::size_t submesh) const
+{
+    return _submeshMaterials[submesh];
 }
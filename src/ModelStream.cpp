@@ -0,0 +1,227 @@
+#include "ModelStream.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+ModelStream::ModelStream(const std::string& filename, const ModelLoadOptions& options)
+    : _filename(filename), _options(options), _thread(&ModelStream::Load, this)
+{
+}
+
+ModelStream::~ModelStream()
+{
+    _cancelled = true;
+    _thread.join();
+}
+
+void ModelStream::Poll(std::vector<MeshBatch>& batches)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_error)
+    {
+        std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+
+    std::move(_batches.begin(), _batches.end(), std::back_inserter(batches));
+    _batches.clear();
+}
+
+std::unique_ptr<Model> ModelStream::TakeModel()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return std::move(_model);
+}
+
+void ModelStream::Load()
+{
+    try
+    {
+        if (_filename.find(".obj") == std::string::npos)
+        {
+            throw std::runtime_error("Error: file is not an obj.");
+        }
+
+        const MappedFile file(_filename);
+        std::unique_ptr<Model> model(new Model());
+        MeshCacheKey key{};
+        bool keyed = false;
+
+        // Hashing the whole file before the first batch only pays off when there
+        // is a cache to check it against, a fresh cache is keyed at the end.
+        std::error_code error;
+        if (_options.useCache && std::filesystem::exists(MeshCache::GetCachePath(_filename), error))
+        {
+            key = MeshCache::MakeKey(_filename, file);
+            keyed = true;
+
+            if (model->LoadCache(_filename, key, Model::GetCacheFlags(_options)))
+            {
+                model->Complete(_filename, _options);
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                _model = std::move(model);
+                return;
+            }
+        }
+
+        const char* it = file.GetData();
+        const char* end = it + file.GetSize();
+
+        // Sized for the first batch rather than the file, it grows with the
+        // vertices actually found.
+        VertexTable uniqueVertices(STREAM_BATCH_SIZE / 32);
+
+        // Triangles referencing a vertex declared further in the file wait for
+        // the end of the file.
+        std::vector<FaceCorner> pending;
+        bool seenFace = false;
+
+        // Runs of the triangles in the order they are appended, which differs
+        // from the file when some wait in `pending`.
+        std::vector<ObjRun> runs;
+        std::vector<ObjRun> pendingRuns;
+        std::string name;
+        std::string material;
+
+        const auto appendRun = [](std::vector<ObjRun>& to, uint32_t triangle, const ObjRun& run) {
+            if (to.empty() || to.back().name != run.name || to.back().material != run.material)
+            {
+                to.push_back(ObjRun{triangle, run.name, run.material});
+            }
+        };
+
+        std::size_t vertexCursor = 0;
+        std::size_t indexCursor = 0;
+        Vector3 positionSum(0, 0, 0);
+        std::size_t positionCount = 0;
+
+        while (it < end)
+        {
+            if (_cancelled)
+            {
+                return;
+            }
+
+            const char* next = it + std::min<std::size_t>(STREAM_BATCH_SIZE, end - it);
+            const void* newline = std::memchr(next, '\n', end - next);
+            next = newline ? static_cast<const char*>(newline) + 1 : end;
+
+            ObjChunk chunk;
+            ParseObjChunk(it, next, chunk);
+            it = next;
+
+            model->_materialLibraries.insert(model->_materialLibraries.end(), chunk.materialLibraries.begin(),
+                                             chunk.materialLibraries.end());
+
+            const std::size_t vertexBase = model->_vertices.size();
+            const std::size_t textureBase = model->_textureCoordinates.size();
+            model->_vertices.insert(model->_vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+
+            // Same rule as a blocking load: without any vt line above the first
+            // face, texture coordinates are generated from the vertices above it.
+            if (chunk.hasFace && !seenFace)
+            {
+                seenFace = true;
+                if (textureBase + chunk.firstFaceTextureCount == 0)
+                {
+                    model->CalculateTextureCoordinates(vertexBase + chunk.firstFaceVertexCount);
+                }
+            }
+
+            model->_textureCoordinates.insert(model->_textureCoordinates.end(), chunk.textureCoordinates.begin(),
+                                              chunk.textureCoordinates.end());
+
+            const auto isResolved = [&](const FaceCorner& corner) {
+                if (corner.vertexIndex >= model->_vertices.size())
+                {
+                    return false;
+                }
+                return corner.textureIndex == NO_TEXTURE_INDEX
+                           ? corner.vertexIndex < model->_textureIndices.size()
+                           : corner.textureIndex < model->_textureCoordinates.size();
+            };
+
+            const std::vector<ObjRun> chunkRuns = ResolveObjRuns(std::span(&chunk, 1), name, material);
+            std::size_t run = 0;
+
+            for (std::size_t i = 0; i < chunk.triangles.size(); i += 3)
+            {
+                const std::span<const FaceCorner> triangle(&chunk.triangles[i], 3);
+
+                while (run + 1 < chunkRuns.size() && chunkRuns[run + 1].firstTriangle <= i / 3)
+                {
+                    ++run;
+                }
+
+                if (std::all_of(triangle.begin(), triangle.end(), isResolved))
+                {
+                    appendRun(runs, model->_verticesIndices.size() / 3, chunkRuns[run]);
+                    model->AppendFaces(triangle, uniqueVertices);
+                }
+                else
+                {
+                    appendRun(pendingRuns, pending.size() / 3, chunkRuns[run]);
+                    pending.insert(pending.end(), triangle.begin(), triangle.end());
+                }
+            }
+
+            Publish(*model, vertexCursor, indexCursor, positionSum, positionCount);
+        }
+
+        // Throws the usual out of bounds errors for indices still unresolved.
+        const uint32_t pendingBase = model->_verticesIndices.size() / 3;
+        for (const ObjRun& run : pendingRuns)
+        {
+            appendRun(runs, pendingBase + run.firstTriangle, run);
+        }
+        model->AppendFaces(pending, uniqueVertices);
+        Publish(*model, vertexCursor, indexCursor, positionSum, positionCount);
+
+        if (_options.useCache && !keyed)
+        {
+            key = MeshCache::MakeKey(_filename, file);
+        }
+        model->Finish(_filename, _options, key, runs);
+        model->Complete(_filename, _options);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _model = std::move(model);
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _error = std::current_exception();
+    }
+}
+
+void ModelStream::Publish(Model& model, std::size_t& vertexCursor, std::size_t& indexCursor, Vector3& positionSum,
+                          std::size_t& positionCount)
+{
+    for (; positionCount < model._vertices.size(); ++positionCount)
+    {
+        const Vector3& position = model._vertices[positionCount];
+        positionSum = Vector3(positionSum.x + position.x, positionSum.y + position.y, positionSum.z + position.z);
+    }
+
+    if (indexCursor == model._verticesIndices.size())
+    {
+        return;
+    }
+
+    MeshBatch batch;
+    batch.vertices.assign(model._vertexBuffer.begin() + vertexCursor, model._vertexBuffer.end());
+    batch.indices.assign(model._verticesIndices.begin() + indexCursor, model._verticesIndices.end());
+    batch.centroid =
+        Vector3(positionSum.x / positionCount, positionSum.y / positionCount, positionSum.z / positionCount);
+
+    vertexCursor = model._vertexBuffer.size();
+    indexCursor = model._verticesIndices.size();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _batches.push_back(std::move(batch));
+}
@@ -0,0 +1,318 @@
+#include "ObjParser.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+
+inline bool IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* SkipBlanks(const char* it, const char* end)
+{
+    while (it < end && IsBlank(*it))
+    {
+        ++it;
+    }
+    return it;
+}
+
+inline const char* SkipToken(const char* it, const char* end)
+{
+    while (it < end && !IsBlank(*it))
+    {
+        ++it;
+    }
+    return it;
+}
+
+// Find the end of the current line without copying it.
+inline const char* FindLineEnd(const char* it, const char* end)
+{
+    const void* newline = std::memchr(it, '\n', end - it);
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+// Parse up to `maxCount` floats separated by blanks, return how many were read.
+// std::from_chars neither allocates nor depends on the locale, unlike
+// std::istringstream.
+std::size_t ParseFloats(const char* it, const char* end, float* values, std::size_t maxCount)
+{
+    std::size_t count = 0;
+
+    while (count < maxCount)
+    {
+        it = SkipBlanks(it, end);
+        if (it < end && *it == '+')
+        {
+            ++it;
+        }
+        if (it >= end)
+        {
+            break;
+        }
+
+        const auto [ptr, ec] = std::from_chars(it, end, values[count]);
+        if (ec != std::errc())
+        {
+            break;
+        }
+        it = ptr;
+        ++count;
+    }
+    return count;
+}
+
+// Parse a face corner such as "7", "7/3", "7//2" or "7/3/2". Normals are
+// ignored since the renderer does not use them.
+FaceCorner ParseFaceCorner(const char* it, const char* end)
+{
+    FaceCorner corner{0, NO_TEXTURE_INDEX};
+
+    const auto [ptr, ec] = std::from_chars(it, end, corner.vertexIndex);
+    if (ec != std::errc() || corner.vertexIndex == 0)
+    {
+        throw std::runtime_error("Error: invalid face index in obj.");
+    }
+    corner.vertexIndex -= 1;
+
+    if (ptr < end && *ptr == '/' && ptr + 1 < end && ptr[1] != '/')
+    {
+        const auto [texPtr, texEc] = std::from_chars(ptr + 1, end, corner.textureIndex);
+        if (texEc != std::errc() || corner.textureIndex == 0 || corner.textureIndex == NO_TEXTURE_INDEX)
+        {
+            throw std::runtime_error("Error: invalid face index in obj.");
+        }
+        corner.textureIndex -= 1;
+    }
+    return corner;
+}
+
+// A cheap first pass that only looks at the first characters of every line, so
+// the containers are allocated once instead of growing while parsing.
+void ReserveChunk(const char* it, const char* end, ObjChunk& chunk)
+{
+    std::size_t vertexCount = 0;
+    std::size_t textureCount = 0;
+    std::size_t triangleCount = 0;
+    std::size_t maxCorners = 0;
+
+    while (it < end)
+    {
+        const char* lineEnd = FindLineEnd(it, end);
+
+        if (lineEnd - it > 2 && it[0] == 'v' && IsBlank(it[1]))
+        {
+            ++vertexCount;
+        }
+        else if (lineEnd - it > 3 && it[0] == 'v' && it[1] == 't' && IsBlank(it[2]))
+        {
+            ++textureCount;
+        }
+        else if (lineEnd - it > 2 && it[0] == 'f' && IsBlank(it[1]))
+        {
+            std::size_t corners = 0;
+            const char* token = SkipBlanks(it + 1, lineEnd);
+            while (token < lineEnd)
+            {
+                ++corners;
+                token = SkipBlanks(SkipToken(token, lineEnd), lineEnd);
+            }
+            if (corners >= 3)
+            {
+                triangleCount += corners - 2;
+            }
+            maxCorners = std::max(maxCorners, corners);
+        }
+        it = lineEnd + 1;
+    }
+
+    chunk.vertices.reserve(vertexCount);
+    chunk.textureCoordinates.reserve(textureCount);
+    chunk.triangles.reserve(triangleCount * 3);
+    chunk.faceCorners.reserve(maxCorners);
+}
+
+// Start a new run at the current triangle, or update the last one if no face
+// came since it started.
+ObjRun& CurrentRun(ObjChunk& chunk)
+{
+    const uint32_t triangle = chunk.triangles.size() / 3;
+
+    if (chunk.runs.empty() || chunk.runs.back().firstTriangle != triangle)
+    {
+        chunk.runs.push_back(ObjRun{triangle, std::nullopt, std::nullopt});
+    }
+    return chunk.runs.back();
+}
+
+// Names may contain blanks, ex: "g left door", only the ends are trimmed.
+std::string ParseName(const char* it, const char* end)
+{
+    it = SkipBlanks(it, end);
+    while (end > it && IsBlank(end[-1]))
+    {
+        --end;
+    }
+    return std::string(it, end);
+}
+
+void ParseLine(const char* begin, const char* end, ObjChunk& chunk)
+{
+    begin = SkipBlanks(begin, end);
+    const char* typeEnd = SkipToken(begin, end);
+    const std::string_view type(begin, typeEnd - begin);
+
+    if (type == "v")
+    {
+        float values[3];
+        if (ParseFloats(typeEnd, end, values, 3) != 3)
+        {
+            throw std::runtime_error("Error: invalid vertex in obj.");
+        }
+        chunk.vertices.emplace_back(values[0], values[1], values[2]);
+    }
+    else if (type == "vt")
+    {
+        float values[2] = {0.0f, 0.0f};
+        if (ParseFloats(typeEnd, end, values, 2) == 0)
+        {
+            throw std::runtime_error("Error: invalid texture coordinate in obj.");
+        }
+        // Subtract 1 to adapt the texture origin to the top-left corner.
+        chunk.textureCoordinates.emplace_back(values[0], 1.0 - values[1]);
+    }
+    else if (type == "f")
+    {
+        if (!chunk.hasFace)
+        {
+            chunk.hasFace = true;
+            chunk.firstFaceVertexCount = chunk.vertices.size();
+            chunk.firstFaceTextureCount = chunk.textureCoordinates.size();
+        }
+
+        // Split each vertex in a corner.
+        // Ex: f 1/1/1 5/2/1 7/3/1 3/4/1 -> corners[0] = 1/1/1.
+        chunk.faceCorners.clear();
+        const char* token = SkipBlanks(typeEnd, end);
+        while (token < end)
+        {
+            const char* tokenEnd = SkipToken(token, end);
+            chunk.faceCorners.push_back(ParseFaceCorner(token, tokenEnd));
+            token = SkipBlanks(tokenEnd, end);
+        }
+
+        if (chunk.faceCorners.size() >= 3)
+        {
+            TriangulateFaces(chunk.faceCorners.data(), chunk.faceCorners.size(), chunk.triangles);
+        }
+    }
+    else if (type == "o" || type == "g")
+    {
+        CurrentRun(chunk).name = ParseName(typeEnd, end);
+    }
+    else if (type == "usemtl")
+    {
+        CurrentRun(chunk).material = ParseName(typeEnd, end);
+    }
+    else if (type == "mtllib")
+    {
+        // Several libraries can be listed on one line.
+        const char* token = SkipBlanks(typeEnd, end);
+        while (token < end)
+        {
+            const char* tokenEnd = SkipToken(token, end);
+            chunk.materialLibraries.emplace_back(token, tokenEnd);
+            token = SkipBlanks(tokenEnd, end);
+        }
+    }
+}
+
+} // namespace
+
+void TriangulateFaces(const FaceCorner* corners, std::size_t count, std::vector<FaceCorner>& triangles)
+{
+    // Fan triangulation around the first corner, 3 corners are appended per
+    // triangle.
+    for (std::size_t i = 1; i < count - 1; ++i)
+    {
+        triangles.push_back(corners[0]);
+        triangles.push_back(corners[i]);
+        triangles.push_back(corners[i + 1]);
+    }
+}
+
+void ParseObjChunk(const char* it, const char* end, ObjChunk& chunk)
+{
+    ReserveChunk(it, end, chunk);
+
+    while (it < end)
+    {
+        const char* lineEnd = FindLineEnd(it, end);
+        ParseLine(it, lineEnd, chunk);
+        it = lineEnd + 1;
+    }
+}
+
+std::vector<const char*> SplitObjInLines(const char* begin, const char* end, std::size_t count)
+{
+    std::vector<const char*> bounds;
+    bounds.reserve(count + 1);
+    bounds.push_back(begin);
+
+    const std::size_t size = end - begin;
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        const char* cut = std::max(begin + size * i / count, bounds.back());
+        cut = FindLineEnd(cut, end);
+        bounds.push_back(cut < end ? cut + 1 : end);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+std::vector<ObjRun> ResolveObjRuns(std::span<const ObjChunk> chunks, std::string& name, std::string& material)
+{
+    std::vector<ObjRun> runs;
+    ObjRun current{0, std::move(name), std::move(material)};
+    uint32_t triangleOffset = 0;
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        for (const ObjRun& run : chunk.runs)
+        {
+            const uint32_t firstTriangle = triangleOffset + run.firstTriangle;
+
+            // The current run is complete, keep it if it holds any triangle.
+            if (firstTriangle > current.firstTriangle)
+            {
+                runs.push_back(current);
+            }
+
+            current.firstTriangle = firstTriangle;
+            if (run.name)
+            {
+                current.name = run.name;
+            }
+            if (run.material)
+            {
+                current.material = run.material;
+            }
+        }
+        triangleOffset += chunk.triangles.size() / 3;
+    }
+
+    if (triangleOffset > current.firstTriangle)
+    {
+        runs.push_back(current);
+    }
+
+    name = std::move(*current.name);
+    material = std::move(*current.material);
+    return runs;
+}
@@ -40,12 +40,95 @@ Application::~Application()
 {
 }
 
+void Application::PrintRenderStats() const
+{
+    const RenderStats& stats = _renderer->GetRenderStats();
+
+    std::cout << "Clusters tested: " << stats.clustersTested << ", backfacing: " << stats.clustersBackfacing
+              << ", outside: " << stats.clustersOutside << ", draw ranges: " << stats.drawRanges
+              << ", triangles: " << stats.trianglesDrawn << ", primitives: " << stats.primitivesDrawn
+              << ", parts drawn: " << stats.partsDrawn << ", skipped: " << stats.partsSkipped
+              << ", texture binds: " << stats.textureBinds << ", draw calls: " << stats.drawCalls << "\n";
+    std::cout << "Texture memory: " << stats.textureBytes / 1024 << " KiB of " << stats.textureBudget / 1024
+              << " KiB, evictions: " << stats.textureEvictions << ", reloads: " << stats.textureReloads << "\n";
+    std::cout << "Frames prefetched: " << stats.framesPrefetched << ", loaded on demand: " << stats.frameDemandLoads
+              << ", cancelled: " << stats.frameLoadsCancelled << "\n";
+    std::cout << "Frames dropped: " << stats.framesDropped << ", late: " << stats.framesLate
+              << ", repeated: " << stats.framesRepeated << ", clock: " << (stats.audioClock ? "audio" : "monotonic")
+              << "\n";
+}
+
+void Application::TogglePlayback()
+{
+    _isPlaying = !_isPlaying;
+
+    if (_isPlaying)
+    {
+        _audioPlayer->Play();
+    }
+    else if (_audioPlayer->GetIsPlaying())
+    {
+        _audioPlayer->Stop();
+    }
+}
+
+void Application::SelectNextSubmesh()
+{
+    const size_t count = _renderer->GetSubmeshCount();
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    _selectedSubmesh = (_selectedSubmesh + 1) % count;
+    const std::string_view name = _renderer->GetSubmeshName(_selectedSubmesh);
+
+    std::cout << "Part " << _selectedSubmesh + 1 << "/" << count << ": " << (name.empty() ? "(unnamed)" : name)
+              << (_renderer->IsSubmeshVisible(_selectedSubmesh) ? "" : " (hidden)") << "\n";
+}
+
+void Application::ToggleSelectedSubmesh()
+{
+    if (_selectedSubmesh >= _renderer->GetSubmeshCount())
+    {
+        return;
+    }
+
+    const bool visible = !_renderer->IsSubmeshVisible(_selectedSubmesh);
+    _renderer->SetSubmeshVisible(_selectedSubmesh, visible);
+
+    std::cout << "Part " << _selectedSubmesh + 1 << " " << (visible ? "shown" : "hidden") << "\n";
+}
+
+void Application::PickModel(float x, float y) const
+{
+    PickResult result;
+
+    if (!_renderer->Pick(x, y, result))
+    {
+        std::cout << "Nothing picked\n";
+        return;
+    }
+
+    const std::string_view name = _renderer->GetSubmeshName(result.submesh);
+    std::cout << "Picked triangle " << result.hit.triangle << " of part " << result.submesh + 1 << ": "
+              << (name.empty() ? "(unnamed)" : name) << ", uv (" << result.hit.uv.u << ", " << result.hit.uv.v
+              << "), distance " << result.hit.distance << "\n";
+}
+
 void Application::Run()
 {
+    _renderer->Start();
 
+    // Measured from here, so the first frame does not include the uploads of Start.
     Uint64 lastTime = SDL_GetPerformanceCounter();
 
-    _renderer->Start();
+    // The first frame and the frames a streamed model loads in would hide the
+    // steady frame times, the histogram starts over after each of them. A frame
+    // is measured at the start of the next one.
+    bool firstFrame = true;
+    bool loadingFrame = true;
 
     while (_isRunning)
 
@@ -55,6 +138,13 @@ void Application::Run()
 
         float deltaTime = (currentTime - lastTime) / (float)SDL_GetPerformanceFrequency();
         lastTime = currentTime;
+        _frameTimes.Add(deltaTime);
+        if (loadingFrame)
+        {
+            _frameTimes.Reset();
+        }
+        loadingFrame = firstFrame || _renderer->IsStreaming();
+        firstFrame = false;
 
         while (SDL_PollEvent(&event))
         {
@@ -62,6 +152,10 @@ void Application::Run()
             {
                 _isRunning = false;
             }
+            else if (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN && event.button.button == SDL_BUTTON_LEFT)
+            {
+                PickModel(event.button.x, event.button.y);
+            }
             else if (event.type == SDL_EVENT_KEY_DOWN)
             {
                 switch (event.key.key)
@@ -87,6 +181,16 @@ void Application::Run()
                 case SDLK_F6:
                     _renderer->PlayBadApple();
                     break;
+                case SDLK_F7:
+                    PrintRenderStats();
+                    _frameTimes.Print(std::cout);
+                    break;
+                case SDLK_N:
+                    SelectNextSubmesh();
+                    break;
+                case SDLK_H:
+                    ToggleSelectedSubmesh();
+                    break;
                 case SDLK_X:
                     _renderer->SetRotationAxis(RotationAxis::X);
                     break;
@@ -100,25 +204,24 @@ void Application::Run()
                     _renderer->SetRotationAxis(RotationAxis::NONE);
                     break;
                 case SDLK_P:
-                    _audioPlayer->GetIsPlaying() ? _audioPlayer->Stop() : _audioPlayer->Play();
+                    TogglePlayback();
                     break;
                 }
             }
         }
 
-        size_t frame = 0;
-
+        // Without audio, the video keeps its own time.
         if (_audioPlayer->GetIsPlaying())
         {
-            double time = _audioPlayer->GetPlaybackTime();
-            frame = static_cast<size_t>(time * BAD_APPLE_FPS);
+            _renderer->SetAudioTime(_audioPlayer->GetPlaybackTime());
         }
-
-        _renderer->SetFrame(frame);
+        _renderer->SetPlaying(_isPlaying);
 
         _camera.Move(deltaTime);
         _renderer->Update(deltaTime, _camera);
         _renderer->Render();
         _renderer->SwapBuffers();
     }
+
+    _frameTimes.Print(std::cout);
 }
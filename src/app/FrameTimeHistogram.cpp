@@ -0,0 +1,52 @@
+#include "app/FrameTimeHistogram.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+void FrameTimeHistogram::Add(double seconds)
+{
+    const double milliseconds = seconds * 1000.0;
+    const auto bucket = std::lower_bound(FRAME_TIME_BUCKETS.begin(), FRAME_TIME_BUCKETS.end(), milliseconds);
+
+    ++_counts[bucket - FRAME_TIME_BUCKETS.begin()];
+    ++_frameCount;
+    _totalTime += milliseconds;
+    _maxTime = std::max(_maxTime, milliseconds);
+}
+
+void FrameTimeHistogram::Reset()
+{
+    *this = FrameTimeHistogram();
+}
+
+void FrameTimeHistogram::Print(std::ostream& out) const
+{
+    if (_frameCount == 0)
+    {
+        return;
+    }
+
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    // Bars are scaled to the largest bucket.
+    const uint64_t largest = *std::max_element(_counts.begin(), _counts.end());
+
+    out << "Frame times over " << _frameCount << " frames, mean " << std::fixed << std::setprecision(2)
+        << _totalTime / _frameCount << " ms, max " << _maxTime << " ms\n";
+
+    for (std::size_t i = 0; i < _counts.size(); ++i)
+    {
+        if (i < FRAME_TIME_BUCKETS.size())
+        {
+            out << "  <= " << std::setw(5) << FRAME_TIME_BUCKETS[i] << " ms: ";
+        }
+        else
+        {
+            out << "   > " << std::setw(5) << FRAME_TIME_BUCKETS.back() << " ms: ";
+        }
+        const std::size_t barLength = static_cast<uint64_t>(_counts[i]) * 40 / largest;
+        out << std::setw(7) << _counts[i] << " " << std::string(barLength, '#') << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -1,11 +1,58 @@
 #include "app/Application.hpp"
 #include <filesystem>
+#include <string_view>
+
+namespace
+{
+
+// Optional stages of the model load and the vertex format, off unless asked
+// for. Return false on an unknown flag.
+bool ParseFlags(int ac, char** av, ModelLoadOptions& options, VertexFormat& vertexFormat)
+{
+    for (int i = 3; i < ac; ++i)
+    {
+        const std::string_view flag(av[i]);
+
+        if (flag == "--weld")
+        {
+            options.weld = true;
+        }
+        else if (flag == "--optimize")
+        {
+            options.optimize = true;
+        }
+        else if (flag == "--lods")
+        {
+            options.generateLods = true;
+        }
+        else if (flag == "--meshlets")
+        {
+            options.buildMeshlets = true;
+        }
+        else if (flag == "--quantize")
+        {
+            vertexFormat = VertexFormat::UNORM16;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
 
 int main(int ac, char** av)
 {
-    if (ac != 3)
+    ModelLoadOptions options;
+    VertexFormat vertexFormat = VertexFormat::FLOAT;
+
+    if (ac < 3 || !ParseFlags(ac, av, options, vertexFormat))
     {
-        std::cerr << "Error: Usage is <scop> <.obj> <texture.tga>" << "\n";
+        std::cerr << "Error: Usage is <scop> <.obj> <texture.tga> [--weld] [--optimize] [--lods] [--meshlets] "
+                     "[--quantize]"
+                  << "\n";
         return 1;
     }
 
@@ -13,7 +60,8 @@ int main(int ac, char** av)
     {
         Application app(1280, 720, "scop");
 
-        app.LoadModel(std::filesystem::path(av[1]));
+        app.SetVertexFormat(vertexFormat);
+        app.LoadModel(std::filesystem::path(av[1]), options);
         app.LoadTexture(std::filesystem::path(av[2]));
         app.LoadNoiseTexture(std::filesystem::path(ASSET_DIR) / "textures" / "solidnoise.tga");
 
@@ -23,4 +71,4 @@ int main(int ac, char** av)
     {
         std::cerr << ex.what() << "\n";
     }
-}
\ No newline at end of file
+}
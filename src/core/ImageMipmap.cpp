@@ -0,0 +1,181 @@
+#include "ImageMipmap.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+// Levels are filtered in 16-bit linear values, which keep the darkest sRGB
+// steps apart. 8-bit sRGB to linear is a table of 256 entries, and back a
+// table of 65536 bytes.
+struct GammaTables
+{
+    std::array<uint16_t, 256> toLinear;
+    std::array<unsigned char, 65536> toSrgb;
+};
+
+const GammaTables& GetGammaTables()
+{
+    static const GammaTables tables = []() {
+        GammaTables result;
+
+        // https://en.wikipedia.org/wiki/SRGB#Transformation
+        for (int i = 0; i < 256; ++i)
+        {
+            const double c = i / 255.0;
+            const double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            result.toLinear[i] = static_cast<uint16_t>(std::lround(linear * 65535.0));
+        }
+        for (int i = 0; i < 65536; ++i)
+        {
+            const double linear = i / 65535.0;
+            const double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+            result.toSrgb[i] = static_cast<unsigned char>(std::lround(c * 255.0));
+        }
+        return result;
+    }();
+    return tables;
+}
+
+// Alpha is not gamma encoded, it only moves to 16 bits and back.
+void ToLinear(const unsigned char* src, uint16_t* dst, std::size_t pixelCount, int channels)
+{
+    const std::array<uint16_t, 256>& toLinear = GetGammaTables().toLinear;
+
+    for (std::size_t i = 0; i < pixelCount * channels; i += channels)
+    {
+        dst[i + 0] = toLinear[src[i + 0]];
+        dst[i + 1] = toLinear[src[i + 1]];
+        dst[i + 2] = toLinear[src[i + 2]];
+        if (channels == 4)
+        {
+            dst[i + 3] = src[i + 3] * 257;
+        }
+    }
+}
+
+void ToSrgb(const uint16_t* src, unsigned char* dst, std::size_t pixelCount, int channels)
+{
+    const std::array<unsigned char, 65536>& toSrgb = GetGammaTables().toSrgb;
+
+    for (std::size_t i = 0; i < pixelCount * channels; i += channels)
+    {
+        dst[i + 0] = toSrgb[src[i + 0]];
+        dst[i + 1] = toSrgb[src[i + 1]];
+        dst[i + 2] = toSrgb[src[i + 2]];
+        if (channels == 4)
+        {
+            dst[i + 3] = (src[i + 3] + 128) / 257;
+        }
+    }
+}
+
+// The channel count is a template parameter so the compiler unrolls the
+// channels and vectorizes across pixels.
+template <int Channels>
+void DownsampleRows(const uint16_t* top, const uint16_t* bottom, uint16_t* output, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        for (int c = 0; c < Channels; ++c)
+        {
+            const uint32_t sum = top[x * 2 * Channels + c] + top[x * 2 * Channels + Channels + c] +
+                                 bottom[x * 2 * Channels + c] + bottom[x * 2 * Channels + Channels + c];
+            output[x * Channels + c] = static_cast<uint16_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+// Half the size, a 1 pixel wide or high level only shrinks along the other
+// axis.
+void Downsample(const uint16_t* src, const MipLevel& from, const MipLevel& to, int channels, uint16_t* dst)
+{
+    const std::size_t srcStride = static_cast<std::size_t>(from.width) * channels;
+
+    for (uint32_t y = 0; y < to.height; ++y)
+    {
+        const uint16_t* top = src + (from.height > 1 ? 2 * y : y) * srcStride;
+        const uint16_t* bottom = from.height > 1 ? top + srcStride : top;
+        uint16_t* output = dst + static_cast<std::size_t>(y) * to.width * channels;
+
+        if (from.width == 1)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                output[c] = static_cast<uint16_t>((top[c] + bottom[c] + 1) >> 1);
+            }
+        }
+        else if (channels == 4)
+        {
+            DownsampleRows<4>(top, bottom, output, to.width);
+        }
+        else
+        {
+            DownsampleRows<3>(top, bottom, output, to.width);
+        }
+    }
+}
+
+} // namespace
+
+std::vector<MipLevel> GetMipLevels(uint32_t width, uint32_t height, int channels)
+{
+    std::vector<MipLevel> levels;
+    std::size_t offset = 0;
+
+    while (true)
+    {
+        levels.push_back(MipLevel{width, height, offset});
+        offset += static_cast<std::size_t>(width) * height * channels;
+        if (width == 1 && height == 1)
+        {
+            return levels;
+        }
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+}
+
+std::size_t GetMipChainSize(std::span<const MipLevel> levels, int channels)
+{
+    const MipLevel& last = levels.back();
+    return last.offset + static_cast<std::size_t>(last.width) * last.height * channels;
+}
+
+void BuildMipChain(const unsigned char* base, std::span<const MipLevel> levels, int channels, unsigned char* chain)
+{
+    if (levels.size() < 2)
+    {
+        return;
+    }
+
+    // Each level is built from the linear values of the previous one, so the
+    // error of the 8-bit encoding does not add up down the chain. Level 0 is
+    // converted two rows at a time, a linear copy of it would be the largest
+    // buffer by far.
+    const MipLevel& first = levels[1];
+    const std::size_t baseStride = static_cast<std::size_t>(levels[0].width) * channels;
+    std::vector<uint16_t> rows(baseStride * 2);
+    std::vector<uint16_t> current(static_cast<std::size_t>(first.width) * first.height * channels);
+    // A level is at most half the previous one, when it is 1 pixel wide or high.
+    std::vector<uint16_t> next(current.size() / 2);
+    const MipLevel pair{levels[0].width, std::min(levels[0].height, 2u), 0};
+
+    for (uint32_t y = 0; y < first.height; ++y)
+    {
+        ToLinear(base + (pair.height > 1 ? 2 * y : y) * baseStride, rows.data(), pair.width * pair.height, channels);
+        Downsample(rows.data(), pair, MipLevel{first.width, 1, 0}, channels,
+                   current.data() + static_cast<std::size_t>(y) * first.width * channels);
+    }
+    ToSrgb(current.data(), chain + first.offset, static_cast<std::size_t>(first.width) * first.height, channels);
+
+    for (std::size_t i = 2; i < levels.size(); ++i)
+    {
+        Downsample(current.data(), levels[i - 1], levels[i], channels, next.data());
+        ToSrgb(next.data(), chain + levels[i].offset, static_cast<std::size_t>(levels[i].width) * levels[i].height,
+               channels);
+        std::swap(current, next);
+    }
+}
@@ -0,0 +1,339 @@
+#include "ImageTGA.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define TGA_SSSE3_DISPATCH 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+constexpr std::size_t TGA_HEADER_SIZE = 18;
+
+constexpr unsigned char TGA_TRUE_COLOR = 2;
+constexpr unsigned char TGA_TRUE_COLOR_RLE = 10;
+
+inline unsigned char Expand5(unsigned int value)
+{
+    // Replicate the high bits, so 31 maps to 255 rather than 248.
+    return static_cast<unsigned char>((value << 3) | (value >> 2));
+}
+
+void SwizzleBGRA(const unsigned char* src, unsigned char* dst, std::size_t count)
+{
+    std::size_t i = 0;
+
+#if defined(__SSE2__)
+    // Blue and red swap places within each 32-bit pixel, green and alpha stay.
+    const __m128i greenAlpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        const __m128i blueRed = _mm_andnot_si128(greenAlpha, p);
+        const __m128i redBlue = _mm_or_si128(_mm_slli_epi32(blueRed, 16), _mm_srli_epi32(blueRed, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_and_si128(p, greenAlpha), redBlue));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t p = vld4q_u8(src + i * 4);
+        const uint8x16_t blue = p.val[0];
+        p.val[0] = p.val[2];
+        p.val[2] = blue;
+        vst4q_u8(dst + i * 4, p);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        dst[i * 4 + 0] = src[i * 4 + 2];
+        dst[i * 4 + 1] = src[i * 4 + 1];
+        dst[i * 4 + 2] = src[i * 4 + 0];
+        dst[i * 4 + 3] = src[i * 4 + 3];
+    }
+}
+
+#if defined(TGA_SSSE3_DISPATCH)
+// SSE2 cannot move bytes across 3-byte pixels, this needs pshufb. Builds for
+// the x86-64 baseline check the CPU at run time.
+__attribute__((target("ssse3"))) std::size_t SwizzleBGRSSSE3(const unsigned char* src, unsigned char* dst,
+                                                            std::size_t count)
+{
+    // 5 pixels per 16 byte load, the last byte is rewritten by the next store.
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    std::size_t i = 0;
+
+    for (; i + 6 <= count; i += 5)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3), _mm_shuffle_epi8(p, shuffle));
+    }
+    return i;
+}
+#endif
+
+void SwizzleBGR(const unsigned char* src, unsigned char* dst, std::size_t count)
+{
+    std::size_t i = 0;
+
+#if defined(TGA_SSSE3_DISPATCH)
+#if defined(__SSSE3__)
+    i = SwizzleBGRSSSE3(src, dst, count);
+#else
+    static const bool hasSSSE3 = __builtin_cpu_supports("ssse3");
+    if (hasSSSE3)
+    {
+        i = SwizzleBGRSSSE3(src, dst, count);
+    }
+#endif
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x3_t p = vld3q_u8(src + i * 3);
+        const uint8x16_t blue = p.val[0];
+        p.val[0] = p.val[2];
+        p.val[2] = blue;
+        vst3q_u8(dst + i * 3, p);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        dst[i * 3 + 0] = src[i * 3 + 2];
+        dst[i * 3 + 1] = src[i * 3 + 1];
+        dst[i * 3 + 2] = src[i * 3 + 0];
+    }
+}
+
+// Little-endian ARRRRRGG GGGBBBBB pixels to opaque RGBA.
+void ExpandBGR555(const unsigned char* src, unsigned char* dst, std::size_t count)
+{
+    std::size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i five = _mm_set1_epi16(0x1F);
+    const __m128i opaque = _mm_set1_epi16(static_cast<short>(0xFF00));
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        __m128i r = _mm_and_si128(_mm_srli_epi16(p, 10), five);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), five);
+        __m128i b = _mm_and_si128(p, five);
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+        // Red and green, then blue and alpha, in 16-bit lanes interleaved into
+        // 32-bit pixels.
+        const __m128i redGreen = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        const __m128i blueAlpha = _mm_or_si128(b, opaque);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(redGreen, blueAlpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(redGreen, blueAlpha));
+    }
+#elif defined(__ARM_NEON)
+    const uint16x8_t five = vdupq_n_u16(0x1F);
+    for (; i + 8 <= count; i += 8)
+    {
+        const uint16x8_t p = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+        const uint16x8_t r = vandq_u16(vshrq_n_u16(p, 10), five);
+        const uint16x8_t g = vandq_u16(vshrq_n_u16(p, 5), five);
+        const uint16x8_t b = vandq_u16(p, five);
+        uint8x8x4_t out;
+        out.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+        out.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 3), vshrq_n_u16(g, 2)));
+        out.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+        out.val[3] = vdup_n_u8(0xFF);
+        vst4_u8(dst + i * 4, out);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const unsigned int pixel = src[i * 2] | (src[i * 2 + 1] << 8);
+        dst[i * 4 + 0] = Expand5((pixel >> 10) & 0x1F);
+        dst[i * 4 + 1] = Expand5((pixel >> 5) & 0x1F);
+        dst[i * 4 + 2] = Expand5(pixel & 0x1F);
+        dst[i * 4 + 3] = 0xFF;
+    }
+}
+
+void DecodePixels(const unsigned char* src, unsigned char* dst, std::size_t count, int bits)
+{
+    if (bits == 32)
+    {
+        SwizzleBGRA(src, dst, count);
+    }
+    else if (bits == 24)
+    {
+        SwizzleBGR(src, dst, count);
+    }
+    else
+    {
+        ExpandBGR555(src, dst, count);
+    }
+}
+
+// Repeat one pixel over size bytes of dst, 48 bytes (16 RGB or 12 RGBA pixels)
+// per copy. Nothing is read back from dst, which may be a mapped pixel buffer
+// in write-combined memory where reads are very slow.
+void FillPixel(unsigned char* dst, std::size_t size, const unsigned char* pixel, std::size_t pixelSize)
+{
+    unsigned char pattern[48];
+    for (std::size_t i = 0; i < sizeof(pattern); i += pixelSize)
+    {
+        std::memcpy(pattern + i, pixel, pixelSize);
+    }
+
+    std::size_t filled = 0;
+    for (; filled + sizeof(pattern) <= size; filled += sizeof(pattern))
+    {
+        std::memcpy(dst + filled, pattern, sizeof(pattern));
+    }
+    std::memcpy(dst + filled, pattern, size - filled);
+}
+
+} // namespace
+
+tImageTGA LoadTGA(const std::string& filename)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const MappedFile file(filename);
+    tImageTGA image = DecodeTGA(reinterpret_cast<const unsigned char*>(file.GetData()), file.GetSize());
+
+    if (image.data.size() >= TGA_REPORT_MIN_SIZE)
+    {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Decoded " << filename << ": " << image.sizeX << "x" << image.sizeY << ", "
+                  << file.GetSize() / (1024.0 * 1024.0) / elapsed.count() << " MB/s\n";
+    }
+    return image;
+}
+
+TGAInfo ReadTGAInfo(const unsigned char* file, std::size_t size)
+{
+    if (size < TGA_HEADER_SIZE)
+    {
+        throw std::runtime_error("Error: Invalid TGA file: truncated header.");
+    }
+
+    const unsigned char idLength = file[0];
+    const unsigned char colorMapType = file[1];
+    const unsigned char imageType = file[2];
+    const std::size_t colorMapLength = file[5] | (file[6] << 8);
+    const std::size_t colorMapEntrySize = file[7];
+
+    TGAInfo info;
+    info.sizeX = file[12] | (file[13] << 8);
+    info.sizeY = file[14] | (file[15] << 8);
+    info.bits = file[16];
+    info.channels = info.bits == 24 ? 3 : 4;
+    info.compressed = imageType == TGA_TRUE_COLOR_RLE;
+
+    if (info.sizeX == 0 || info.sizeY == 0 || (info.bits != 24 && info.bits != 32 && info.bits != 16))
+    {
+        throw std::runtime_error("Error: Invalid TGA file: Unsupported dimensions or pixel format.");
+    }
+    if (imageType != TGA_TRUE_COLOR && imageType != TGA_TRUE_COLOR_RLE)
+    {
+        throw std::runtime_error("Error: Invalid TGA file: Unsupported image type.");
+    }
+
+    // A true color image may still carry a color map, which is skipped.
+    info.dataOffset = TGA_HEADER_SIZE + idLength;
+    if (colorMapType == 1)
+    {
+        info.dataOffset += colorMapLength * ((colorMapEntrySize + 7) / 8);
+    }
+
+    // A RLE packet of at least 2 bytes expands to at most 128 pixels, so a
+    // short file cannot claim a huge image and have it allocated before failing.
+    const std::size_t pixelCount = static_cast<std::size_t>(info.sizeX) * info.sizeY;
+    const std::size_t minDataSize = info.compressed ? pixelCount / 128 : pixelCount * (info.bits / 8);
+    if (info.dataOffset > size || size - info.dataOffset < minDataSize)
+    {
+        throw std::runtime_error("Error: Invalid TGA file: truncated pixel data.");
+    }
+    return info;
+}
+
+tImageTGA DecodeTGA(const unsigned char* file, std::size_t size)
+{
+    const TGAInfo info = ReadTGAInfo(file, size);
+    tImageTGA image;
+    image.sizeX = info.sizeX;
+    image.sizeY = info.sizeY;
+    image.channels = info.channels;
+    image.data.resize(info.GetDecodedSize());
+
+    DecodeTGA(file, size, info, image.data.data());
+    return image;
+}
+
+void DecodeTGA(const unsigned char* file, std::size_t size, const TGAInfo& info, unsigned char* output)
+{
+    const std::size_t pixelCount = static_cast<std::size_t>(info.sizeX) * info.sizeY;
+    const int bytesPerPixel = info.bits / 8;
+
+    if (!info.compressed)
+    {
+        // Rows have no padding, the whole image is one run of pixels.
+        DecodePixels(file + info.dataOffset, output, pixelCount, info.bits);
+        return;
+    }
+
+    // RLE compressed, decoded to the same layout as uncompressed files.
+    const unsigned char* it = file + info.dataOffset;
+    const unsigned char* end = file + size;
+    std::size_t pixelsRead = 0;
+
+    while (pixelsRead < pixelCount)
+    {
+        if (it == end)
+        {
+            throw std::runtime_error("Error: Invalid TGA file: truncated pixel data.");
+        }
+
+        // The low 7 bits hold the run length minus one.
+        const unsigned char packet = *it++;
+        const std::size_t count = (packet & 0x7F) + 1;
+        const bool repeat = packet & 0x80;
+        const std::size_t packetSize = repeat ? bytesPerPixel : count * bytesPerPixel;
+
+        if (count > pixelCount - pixelsRead)
+        {
+            throw std::runtime_error("Error: Invalid TGA file: RLE packet overflows the image.");
+        }
+        if (static_cast<std::size_t>(end - it) < packetSize)
+        {
+            throw std::runtime_error("Error: Invalid TGA file: truncated pixel data.");
+        }
+
+        // A repeat run converts its one pixel, a raw run all of them.
+        unsigned char* dst = output + pixelsRead * info.channels;
+        if (repeat)
+        {
+            unsigned char pixel[4];
+            DecodePixels(it, pixel, 1, info.bits);
+            FillPixel(dst, count * info.channels, pixel, info.channels);
+        }
+        else
+        {
+            DecodePixels(it, dst, count, info.bits);
+        }
+        it += packetSize;
+        pixelsRead += count;
+    }
+}
@@ -0,0 +1,60 @@
+#include "MappedFile.hpp"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& filename) : _data(nullptr), _size(0)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd == -1)
+    {
+        const std::string error = "Error: Cannot open file: " + filename;
+        throw std::runtime_error(error);
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == -1)
+    {
+        close(fd);
+        const std::string error = "Error: Cannot stat file: " + filename;
+        throw std::runtime_error(error);
+    }
+
+    _size = static_cast<std::size_t>(st.st_size);
+
+    // mmap refuses a zero length, an empty file is simply an empty view.
+    if (_size == 0)
+    {
+        close(fd);
+        return;
+    }
+
+    void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps its own reference to the file, the descriptor is no
+    // longer needed.
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        const std::string error = "Error: Cannot map file: " + filename;
+        throw std::runtime_error(error);
+    }
+
+    // Parsers walk the file front to back, let the kernel read ahead aggressively.
+    madvise(data, _size, MADV_SEQUENTIAL);
+
+    _data = static_cast<const char*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data)
+    {
+        munmap(const_cast<char*>(_data), _size);
+    }
+}
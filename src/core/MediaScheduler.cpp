@@ -0,0 +1,69 @@
+#include "MediaScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+
+MediaScheduler::MediaScheduler(double frameRate, std::size_t frameCount)
+    : _frameRate(frameRate), _frameCount(std::max<std::size_t>(frameCount, 1))
+{
+}
+
+void MediaScheduler::SetAudioTime(double seconds)
+{
+    _audioTime = std::max(seconds, 0.0);
+    _hasAudioTime = true;
+}
+
+std::size_t MediaScheduler::Update(double deltaTime)
+{
+    _clock = _hasAudioTime ? MediaClock::AUDIO : MediaClock::MONOTONIC;
+    _hasAudioTime = false;
+
+    if (_playing)
+    {
+        _time = _clock == MediaClock::AUDIO ? _audioTime : _time + deltaTime;
+    }
+
+    std::size_t frame = static_cast<std::size_t>(_time * _frameRate);
+
+    if (_clock == MediaClock::AUDIO)
+    {
+        frame = std::min(frame, _frameCount - 1);
+    }
+    else if (frame >= _frameCount)
+    {
+        // Wrapping the time too keeps its precision over long runs.
+        _time = std::fmod(_time, _frameCount / _frameRate);
+        frame %= _frameCount;
+    }
+
+    if (frame != _dueFrame)
+    {
+        const std::size_t skipped = (frame + _frameCount - _dueFrame) % _frameCount - 1;
+
+        if (skipped < MEDIA_SEEK_THRESHOLD * _frameRate)
+        {
+            _droppedCount += skipped + (_duePresented ? 0 : 1);
+        }
+        _dueFrame = frame;
+        _dueTicks = 0;
+        _duePresented = false;
+    }
+    return _dueFrame;
+}
+
+void MediaScheduler::Present(std::size_t frame)
+{
+    if (frame == _dueFrame)
+    {
+        if (!_duePresented && _dueTicks > 0)
+        {
+            ++_lateCount;
+        }
+        _duePresented = true;
+    }
+    else
+    {
+        ++_repeatedCount;
+    }
+    ++_dueTicks;
+}
@@ -0,0 +1,408 @@
+#include "MonoVideo.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+constexpr char MONO_VIDEO_MAGIC[8] = {'S', 'C', 'O', 'P', 'M', 'V', 'I', 'D'};
+
+static_assert(sizeof(MonoVideoHeader) % 8 == 0, "Frame table must stay aligned after the header");
+
+constexpr uint32_t NO_FRAME = std::numeric_limits<uint32_t>::max();
+
+// Far larger than any texture GL accepts, so the plane size cannot overflow.
+constexpr uint32_t MONO_VIDEO_MAX_SIZE = 1u << 16;
+
+// Shorter repeats cost less as part of a literal.
+constexpr std::size_t MIN_RUN_LENGTH = 3;
+
+inline std::size_t GetStride(uint32_t width)
+{
+    return (static_cast<std::size_t>(width) + 7) / 8;
+}
+
+inline std::size_t GetKeyframeTableSize(uint32_t keyframeCount)
+{
+    return (static_cast<std::size_t>(keyframeCount) * sizeof(uint32_t) + 7) & ~std::size_t(7);
+}
+
+// LEB128, 7 bits per byte with the high bit set on all but the last.
+void AppendVarint(std::vector<unsigned char>& output, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        output.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<unsigned char>(value));
+}
+
+bool ReadVarint(const unsigned char*& src, const unsigned char* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && src < end; shift += 7)
+    {
+        const unsigned char byte = *src++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tokens of a varint, length << 1 | repeat, followed by the byte to repeat or
+// the literal bytes.
+void EncodeRuns(const unsigned char* data, std::size_t size, std::vector<unsigned char>& output)
+{
+    std::size_t literalStart = 0;
+    std::size_t i = 0;
+
+    const auto flushLiteral = [&](std::size_t end) {
+        if (end > literalStart)
+        {
+            AppendVarint(output, (end - literalStart) << 1);
+            output.insert(output.end(), data + literalStart, data + end);
+        }
+    };
+
+    while (i < size)
+    {
+        std::size_t run = 1;
+        while (i + run < size && data[i + run] == data[i])
+        {
+            ++run;
+        }
+
+        if (run >= MIN_RUN_LENGTH)
+        {
+            flushLiteral(i);
+            AppendVarint(output, (run << 1) | 1);
+            output.push_back(data[i]);
+            literalStart = i + run;
+        }
+        i += run;
+    }
+    flushLiteral(size);
+}
+
+// Expand the runs into `plane`, or XOR them into it for a delta. Runs of zero,
+// most of a delta, then cost nothing.
+void DecodeRuns(const unsigned char* src, std::size_t size, unsigned char* plane, std::size_t planeSize, bool delta)
+{
+    const unsigned char* end = src + size;
+    std::size_t position = 0;
+
+    while (src < end)
+    {
+        uint64_t token;
+        if (!ReadVarint(src, end, token) || (token >> 1) > planeSize - position)
+        {
+            throw std::runtime_error("Error: Corrupt video frame");
+        }
+        const std::size_t length = token >> 1;
+
+        if (token & 1)
+        {
+            if (src == end)
+            {
+                throw std::runtime_error("Error: Corrupt video frame");
+            }
+            const unsigned char value = *src++;
+
+            if (!delta)
+            {
+                std::memset(plane + position, value, length);
+            }
+            else if (value != 0)
+            {
+                for (std::size_t i = 0; i < length; ++i)
+                {
+                    plane[position + i] ^= value;
+                }
+            }
+        }
+        else
+        {
+            if (length > static_cast<std::size_t>(end - src))
+            {
+                throw std::runtime_error("Error: Corrupt video frame");
+            }
+
+            if (!delta)
+            {
+                std::memcpy(plane + position, src, length);
+            }
+            else
+            {
+                for (std::size_t i = 0; i < length; ++i)
+                {
+                    plane[position + i] ^= src[i];
+                }
+            }
+            src += length;
+        }
+        position += length;
+    }
+
+    if (position != planeSize)
+    {
+        throw std::runtime_error("Error: Corrupt video frame");
+    }
+}
+
+// Most significant bit first, the leftmost pixel.
+void ExpandPlane(const unsigned char* plane, uint32_t width, uint32_t height, unsigned char* pixels)
+{
+    // The 8 RGB pixels of each byte.
+    static const std::array<std::array<unsigned char, 24>, 256> table = []() {
+        std::array<std::array<unsigned char, 24>, 256> result;
+        for (int byte = 0; byte < 256; ++byte)
+        {
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                const unsigned char value = (byte >> (7 - bit)) & 1 ? 255 : 0;
+                std::memset(result[byte].data() + bit * 3, value, 3);
+            }
+        }
+        return result;
+    }();
+
+    const std::size_t stride = GetStride(width);
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const unsigned char* row = plane + y * stride;
+        unsigned char* output = pixels + static_cast<std::size_t>(y) * width * 3;
+        uint32_t x = 0;
+
+        for (; x + 8 <= width; x += 8)
+        {
+            std::memcpy(output + x * 3, table[row[x / 8]].data(), 24);
+        }
+        for (; x < width; ++x)
+        {
+            std::memset(output + x * 3, (row[x / 8] >> (7 - x % 8)) & 1 ? 255 : 0, 3);
+        }
+    }
+}
+
+} // namespace
+
+MonoVideo::MonoVideo(const std::string& path) : _file(path), _planeFrame(NO_FRAME)
+{
+    if (_file.GetSize() < sizeof(_header))
+    {
+        throw std::runtime_error("Error: Truncated video: " + path);
+    }
+
+    std::memcpy(&_header, _file.GetData(), sizeof(_header));
+
+    if (std::memcmp(_header.magic, MONO_VIDEO_MAGIC, sizeof(MONO_VIDEO_MAGIC)) != 0 ||
+        _header.version != MONO_VIDEO_VERSION || _header.headerSize != sizeof(_header))
+    {
+        throw std::runtime_error("Error: Not a video, or one from another version: " + path);
+    }
+
+    // Check the counts on their own first, a garbage count could overflow the
+    // table sizes below.
+    const std::size_t size = _file.GetSize();
+
+    if (_header.width == 0 || _header.height == 0 || _header.width > MONO_VIDEO_MAX_SIZE ||
+        _header.height > MONO_VIDEO_MAX_SIZE || _header.frameRate == 0 || _header.frameCount == 0 ||
+        _header.frameCount > size || _header.keyframeCount == 0 || _header.keyframeCount > _header.frameCount ||
+        size - sizeof(_header) <
+            _header.frameCount * sizeof(MonoVideoFrame) + GetKeyframeTableSize(_header.keyframeCount))
+    {
+        throw std::runtime_error("Error: Corrupt video: " + path);
+    }
+
+    const char* tables = _file.GetData() + sizeof(_header);
+    _frames = std::span<const MonoVideoFrame>(reinterpret_cast<const MonoVideoFrame*>(tables), _header.frameCount);
+    _keyframes = std::span<const uint32_t>(
+        reinterpret_cast<const uint32_t*>(tables + _header.frameCount * sizeof(MonoVideoFrame)), _header.keyframeCount);
+
+    for (const MonoVideoFrame& frame : _frames)
+    {
+        if (frame.offset > size || frame.size > size - frame.offset)
+        {
+            throw std::runtime_error("Error: Corrupt video: " + path);
+        }
+    }
+
+    // Seeks look for the last keyframe at or before a frame, the first one
+    // must be there.
+    for (std::size_t i = 0; i < _keyframes.size(); ++i)
+    {
+        if ((i == 0 && _keyframes[i] != 0) || (i > 0 && _keyframes[i] <= _keyframes[i - 1]) ||
+            _keyframes[i] >= _header.frameCount || !(_frames[_keyframes[i]].flags & MONO_VIDEO_KEYFRAME))
+        {
+            throw std::runtime_error("Error: Corrupt video: " + path);
+        }
+    }
+
+    _plane.resize(GetStride(_header.width) * _header.height);
+}
+
+void MonoVideo::DecodeFrame(uint32_t frame, unsigned char* pixels)
+{
+    if (frame >= _header.frameCount)
+    {
+        throw std::runtime_error("Error: Video frame out of range");
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint32_t keyframe = *(std::upper_bound(_keyframes.begin(), _keyframes.end(), frame) - 1);
+    uint32_t next = keyframe;
+
+    // Carry on from the plane when it is between the keyframe and the frame.
+    if (_planeFrame != NO_FRAME && _planeFrame >= keyframe && _planeFrame <= frame)
+    {
+        next = _planeFrame + 1;
+    }
+
+    // A corrupt frame throws half way, the plane is then unusable.
+    _planeFrame = NO_FRAME;
+    for (uint32_t i = next; i <= frame; ++i)
+    {
+        ApplyFrame(i);
+    }
+    _planeFrame = frame;
+
+    ExpandPlane(_plane.data(), _header.width, _header.height, pixels);
+}
+
+void MonoVideo::ApplyFrame(uint32_t frame)
+{
+    const MonoVideoFrame& entry = _frames[frame];
+
+    DecodeRuns(reinterpret_cast<const unsigned char*>(_file.GetData()) + entry.offset, entry.size, _plane.data(),
+               _plane.size(), !(entry.flags & MONO_VIDEO_KEYFRAME));
+    ++_decodedCount;
+}
+
+MonoVideoWriter::MonoVideoWriter(uint32_t width, uint32_t height, uint32_t frameRate)
+    : _width(width), _height(height), _frameRate(frameRate)
+{
+}
+
+void MonoVideoWriter::AddFrame(const unsigned char* pixels, int channels)
+{
+    const std::size_t stride = GetStride(_width);
+    std::vector<unsigned char> plane(stride * _height, 0);
+
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        for (uint32_t x = 0; x < _width; ++x)
+        {
+            const unsigned char* pixel = pixels + (static_cast<std::size_t>(y) * _width + x) * channels;
+            if (pixel[0] + pixel[1] + pixel[2] >= MONO_VIDEO_THRESHOLD * 3)
+            {
+                plane[y * stride + x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+    }
+
+    const uint32_t index = static_cast<uint32_t>(_frames.size());
+    std::vector<unsigned char> key;
+    EncodeRuns(plane.data(), plane.size(), key);
+
+    // A scene cut makes the delta larger than the frame itself, the frame is
+    // then a keyframe too.
+    bool isKeyframe = _keyframes.empty() || index - _keyframes.back() >= MONO_VIDEO_KEYFRAME_INTERVAL;
+    std::vector<unsigned char> delta;
+
+    if (!isKeyframe)
+    {
+        std::vector<unsigned char> difference(plane.size());
+        for (std::size_t i = 0; i < plane.size(); ++i)
+        {
+            difference[i] = plane[i] ^ _previous[i];
+        }
+        EncodeRuns(difference.data(), difference.size(), delta);
+        isKeyframe = key.size() <= delta.size();
+    }
+
+    const std::vector<unsigned char>& data = isKeyframe ? key : delta;
+    _frames.push_back(MonoVideoFrame{_payload.size(), static_cast<uint32_t>(data.size()),
+                                     isKeyframe ? MONO_VIDEO_KEYFRAME : 0});
+    if (isKeyframe)
+    {
+        _keyframes.push_back(index);
+    }
+    _payload.insert(_payload.end(), data.begin(), data.end());
+    _previous = std::move(plane);
+}
+
+void MonoVideoWriter::Write(const std::string& path) const
+{
+    if (_frames.empty())
+    {
+        throw std::runtime_error("Error: Video without frames: " + path);
+    }
+
+    MonoVideoHeader header{};
+    std::memcpy(header.magic, MONO_VIDEO_MAGIC, sizeof(MONO_VIDEO_MAGIC));
+    header.version = MONO_VIDEO_VERSION;
+    header.headerSize = sizeof(header);
+    header.width = _width;
+    header.height = _height;
+    header.frameCount = static_cast<uint32_t>(_frames.size());
+    header.frameRate = _frameRate;
+    header.keyframeCount = static_cast<uint32_t>(_keyframes.size());
+
+    const std::size_t keyframeTableSize = GetKeyframeTableSize(header.keyframeCount);
+    const uint64_t payloadOffset = sizeof(header) + _frames.size() * sizeof(MonoVideoFrame) + keyframeTableSize;
+
+    std::vector<MonoVideoFrame> frames = _frames;
+    for (MonoVideoFrame& frame : frames)
+    {
+        frame.offset += payloadOffset;
+    }
+
+    std::vector<unsigned char> keyframeTable(keyframeTableSize, 0);
+    std::memcpy(keyframeTable.data(), _keyframes.data(), _keyframes.size() * sizeof(uint32_t));
+
+    // Write to a temporary file renamed at the end, a crash or a concurrent
+    // reader never sees a half written video.
+    const std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Error: Cannot write video: " + path);
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(frames.data()), frames.size() * sizeof(MonoVideoFrame));
+        file.write(reinterpret_cast<const char*>(keyframeTable.data()), keyframeTable.size());
+        file.write(reinterpret_cast<const char*>(_payload.data()), _payload.size());
+
+        if (!file.good())
+        {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("Error: Cannot write video: " + path);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    if (error)
+    {
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Error: Cannot write video: " + path);
+    }
+}
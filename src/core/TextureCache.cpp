@@ -0,0 +1,157 @@
+#include "TextureCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+
+constexpr char TEXTURE_CACHE_MAGIC[8] = {'S', 'C', 'O', 'P', 'T', 'E', 'X', 'B'};
+
+static_assert(sizeof(TextureCacheHeader) % 8 == 0, "Payload must stay aligned after the header");
+
+// Far larger than any texture GL accepts, so the level sizes cannot overflow.
+constexpr uint32_t TEXTURE_CACHE_MAX_SIZE = 1u << 16;
+
+} // namespace
+
+std::string TextureCache::GetCachePath(const std::string& sourcePath)
+{
+    return sourcePath + TEXTURE_CACHE_EXTENSION;
+}
+
+TextureCache::TextureCache(std::unique_ptr<MappedFile> file, const TextureCacheHeader& header)
+    : _file(std::move(file)), _header(header),
+      _levels(GetCompressedLevels(header.width, header.height, static_cast<BlockFormat>(header.format)))
+{
+}
+
+std::unique_ptr<TextureCache> TextureCache::Open(const std::string& sourcePath, const MeshCacheKey& key)
+{
+    const std::string path = GetCachePath(sourcePath);
+    std::error_code error;
+
+    if (!std::filesystem::exists(path, error))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file;
+
+    try
+    {
+        file = std::make_unique<MappedFile>(path);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Warning: ignoring texture cache: " << ex.what() << "\n";
+        return nullptr;
+    }
+
+    TextureCacheHeader header;
+
+    if (file->GetSize() < sizeof(header))
+    {
+        std::cerr << "Warning: ignoring truncated texture cache: " << path << "\n";
+        return nullptr;
+    }
+
+    std::memcpy(&header, file->GetData(), sizeof(header));
+
+    if (std::memcmp(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC)) != 0 ||
+        header.version != TEXTURE_CACHE_VERSION || header.headerSize != sizeof(header))
+    {
+        std::cerr << "Warning: ignoring texture cache from another version: " << path << "\n";
+        return nullptr;
+    }
+
+    if (header.key.sourceSize != key.sourceSize || header.key.sourceTime != key.sourceTime ||
+        header.key.sourceHash != key.sourceHash)
+    {
+        // The TGA changed since the cache was written, rebuild it silently.
+        return nullptr;
+    }
+
+    const BlockFormat format = static_cast<BlockFormat>(header.format);
+
+    if ((format != BlockFormat::BC1 && format != BlockFormat::BC3 && format != BlockFormat::BC4) ||
+        header.width == 0 || header.height == 0 || header.width > TEXTURE_CACHE_MAX_SIZE ||
+        header.height > TEXTURE_CACHE_MAX_SIZE)
+    {
+        std::cerr << "Warning: ignoring corrupt texture cache: " << path << "\n";
+        return nullptr;
+    }
+
+    // Damaged blocks only decode to wrong texels, the sizes are all that must
+    // be checked.
+    std::unique_ptr<TextureCache> cache(new TextureCache(std::move(file), header));
+
+    if (header.levelCount != cache->_levels.size() ||
+        header.payloadSize != GetCompressedSize(cache->_levels, format) ||
+        cache->_file->GetSize() - sizeof(header) != header.payloadSize)
+    {
+        std::cerr << "Warning: ignoring corrupt texture cache: " << path << "\n";
+        return nullptr;
+    }
+    return cache;
+}
+
+bool TextureCache::Write(const std::string& sourcePath, const MeshCacheKey& key, BlockFormat format, uint32_t width,
+                         uint32_t height, std::span<const unsigned char> blocks)
+{
+    TextureCacheHeader header{};
+    std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+    header.version = TEXTURE_CACHE_VERSION;
+    header.headerSize = sizeof(header);
+    header.key = key;
+    header.format = static_cast<uint32_t>(format);
+    header.width = width;
+    header.height = height;
+    header.levelCount = GetCompressedLevels(width, height, format).size();
+    header.payloadSize = blocks.size();
+
+    // Write to a temporary file renamed at the end, a crash or a concurrent
+    // reader never sees a half written cache.
+    const std::string path = GetCachePath(sourcePath);
+    const std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            std::cerr << "Warning: cannot write texture cache: " << path << "\n";
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+
+        if (!file.good())
+        {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            std::cerr << "Warning: cannot write texture cache: " << path << "\n";
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    if (error)
+    {
+        std::remove(temporaryPath.c_str());
+        std::cerr << "Warning: cannot write texture cache: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::span<const unsigned char> TextureCache::GetBlocks() const
+{
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(_file->GetData() + sizeof(TextureCacheHeader));
+    return std::span<const unsigned char>(data, _header.payloadSize);
+}
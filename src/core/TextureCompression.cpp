@@ -0,0 +1,630 @@
+#include "TextureCompression.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace
+{
+
+// Starting a thread for fewer blocks costs more than it saves.
+constexpr std::size_t MIN_BLOCKS_PER_THREAD = 1024;
+
+// Least squares fits of the endpoints after the principal axis guess, each
+// only kept when it lowers the error.
+constexpr int COLOR_REFINE_PASSES = 2;
+
+// Weight of the first endpoint for each BC1 index, in 4 color mode.
+constexpr std::array<float, 4> COLOR_WEIGHTS = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+inline void Unpack565(uint16_t color, int rgb[3])
+{
+    const int r = (color >> 11) & 31;
+    const int g = (color >> 5) & 63;
+    const int b = color & 31;
+
+    // Replicate the high bits, so 31 maps to 255 rather than 248.
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+inline uint16_t Pack565(float r, float g, float b)
+{
+    const auto quantize = [](float value, int max) {
+        return static_cast<int>(std::clamp(value, 0.0f, 255.0f) * max / 255.0f + 0.5f);
+    };
+    return static_cast<uint16_t>((quantize(r, 31) << 11) | (quantize(g, 63) << 5) | quantize(b, 31));
+}
+
+// The 4 colors of a BC1 block, as decoders compute them. The third color is
+// the mean of the endpoints and the fourth transparent black in 3 color mode.
+void GetColorPalette(uint16_t c0, uint16_t c1, bool fourColors, int palette[4][3])
+{
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        if (fourColors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// The 8 values of a BC4 block, or an alpha block of BC3. 6 values and 0 and
+// 255 when the first endpoint is not the larger one.
+void GetValuePalette(int v0, int v1, int palette[8])
+{
+    palette[0] = v0;
+    palette[1] = v1;
+
+    if (v0 > v1)
+    {
+        for (int k = 2; k < 8; ++k)
+        {
+            palette[k] = ((8 - k) * v0 + (k - 1) * v1 + 3) / 7;
+        }
+    }
+    else
+    {
+        for (int k = 2; k < 6; ++k)
+        {
+            palette[k] = ((6 - k) * v0 + (k - 1) * v1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+struct ColorFit
+{
+    uint16_t c0;
+    uint16_t c1;
+    uint32_t indices;
+    uint32_t error;
+};
+
+// Pick the nearest color of the palette for each texel. The larger endpoint
+// goes first, which selects 4 color mode, except when both are equal and every
+// texel takes the first one anyway.
+ColorFit FitColors(const unsigned char* texels, uint16_t a, uint16_t b)
+{
+    ColorFit fit{std::max(a, b), std::min(a, b), 0, 0};
+    int palette[4][3];
+    GetColorPalette(fit.c0, fit.c1, true, palette);
+    const int paletteSize = fit.c0 == fit.c1 ? 1 : 4;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const unsigned char* texel = texels + i * 4;
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        uint32_t bestIndex = 0;
+
+        for (int k = 0; k < paletteSize; ++k)
+        {
+            const int dr = texel[0] - palette[k][0];
+            const int dg = texel[1] - palette[k][1];
+            const int db = texel[2] - palette[k][2];
+            const uint32_t error = dr * dr + dg * dg + db * db;
+            if (error < best)
+            {
+                best = error;
+                bestIndex = k;
+            }
+        }
+        fit.indices |= bestIndex << (i * 2);
+        fit.error += best;
+    }
+    return fit;
+}
+
+// Endpoints of a texel of a single color: the pair of each channel whose two
+// thirds mix is nearest the value, as 565 alone is off by up to 4.
+// https://github.com/nothings/stb/blob/master/stb_dxt.h
+struct SingleColorTables
+{
+    std::array<std::array<uint8_t, 2>, 256> five;
+    std::array<std::array<uint8_t, 2>, 256> six;
+};
+
+const SingleColorTables& GetSingleColorTables()
+{
+    static const SingleColorTables tables = []() {
+        SingleColorTables result;
+
+        const auto build = [](std::array<std::array<uint8_t, 2>, 256>& table, int bits) {
+            const int max = (1 << bits) - 1;
+            const auto expand = [bits](int value) { return (value << (8 - bits)) | (value >> (2 * bits - 8)); };
+
+            for (int v = 0; v < 256; ++v)
+            {
+                int bestError = 256;
+                for (int hi = 0; hi <= max; ++hi)
+                {
+                    for (int lo = 0; lo <= max; ++lo)
+                    {
+                        const int error = std::abs((2 * expand(hi) + expand(lo)) / 3 - v);
+                        if (error < bestError)
+                        {
+                            bestError = error;
+                            table[v] = {static_cast<uint8_t>(hi), static_cast<uint8_t>(lo)};
+                        }
+                    }
+                }
+            }
+        };
+        build(result.five, 5);
+        build(result.six, 6);
+        return result;
+    }();
+    return tables;
+}
+
+ColorFit FitSingleColor(const unsigned char* texels)
+{
+    const SingleColorTables& tables = GetSingleColorTables();
+    const auto& r = tables.five[texels[0]];
+    const auto& g = tables.six[texels[1]];
+    const auto& b = tables.five[texels[2]];
+
+    const ColorFit mixed = FitColors(texels, static_cast<uint16_t>((r[0] << 11) | (g[0] << 5) | b[0]),
+                                     static_cast<uint16_t>((r[1] << 11) | (g[1] << 5) | b[1]));
+    const uint16_t plain = Pack565(texels[0], texels[1], texels[2]);
+    const ColorFit rounded = FitColors(texels, plain, plain);
+    return mixed.error <= rounded.error ? mixed : rounded;
+}
+
+// Solve for the endpoints that best reproduce the texels with their current
+// indices.
+bool RefineColors(const unsigned char* texels, const ColorFit& fit, uint16_t& c0, uint16_t& c1)
+{
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = {}, bx[3] = {};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const float a = COLOR_WEIGHTS[(fit.indices >> (i * 2)) & 3];
+        const float b = 1.0f - a;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (int c = 0; c < 3; ++c)
+        {
+            ax[c] += a * texels[i * 4 + c];
+            bx[c] += b * texels[i * 4 + c];
+        }
+    }
+
+    // Every texel on the same index.
+    const float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f)
+    {
+        return false;
+    }
+
+    float e0[3], e1[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        e0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+        e1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+    }
+    c0 = Pack565(e0[0], e0[1], e0[2]);
+    c1 = Pack565(e1[0], e1[1], e1[2]);
+    return true;
+}
+
+// The texels spread along one direction of the color cube, found with a few
+// power iterations on their covariance. Its extreme texels are the first
+// guess of the endpoints.
+ColorFit FitColorBlock(const unsigned char* texels)
+{
+    float mean[3] = {};
+    int low[3] = {255, 255, 255};
+    int high[3] = {0, 0, 0};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            mean[c] += texels[i * 4 + c];
+            low[c] = std::min<int>(low[c], texels[i * 4 + c]);
+            high[c] = std::max<int>(high[c], texels[i * 4 + c]);
+        }
+    }
+    if (low[0] == high[0] && low[1] == high[1] && low[2] == high[2])
+    {
+        return FitSingleColor(texels);
+    }
+
+    float covariance[6] = {};
+    for (int c = 0; c < 3; ++c)
+    {
+        mean[c] /= 16.0f;
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        const float r = texels[i * 4 + 0] - mean[0];
+        const float g = texels[i * 4 + 1] - mean[1];
+        const float b = texels[i * 4 + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    float axis[3] = {static_cast<float>(high[0] - low[0]), static_cast<float>(high[1] - low[1]),
+                     static_cast<float>(high[2] - low[2])};
+    for (int iteration = 0; iteration < 4; ++iteration)
+    {
+        const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        const float largest = std::max({std::abs(x), std::abs(y), std::abs(z)});
+        if (largest == 0.0f)
+        {
+            break;
+        }
+        axis[0] = x / largest;
+        axis[1] = y / largest;
+        axis[2] = z / largest;
+    }
+
+    int minTexel = 0, maxTexel = 0;
+    float minDot = std::numeric_limits<float>::max();
+    float maxDot = std::numeric_limits<float>::lowest();
+    for (int i = 0; i < 16; ++i)
+    {
+        const float dot = texels[i * 4] * axis[0] + texels[i * 4 + 1] * axis[1] + texels[i * 4 + 2] * axis[2];
+        if (dot < minDot)
+        {
+            minDot = dot;
+            minTexel = i;
+        }
+        if (dot > maxDot)
+        {
+            maxDot = dot;
+            maxTexel = i;
+        }
+    }
+
+    const unsigned char* hi = texels + maxTexel * 4;
+    const unsigned char* lo = texels + minTexel * 4;
+    ColorFit best = FitColors(texels, Pack565(hi[0], hi[1], hi[2]), Pack565(lo[0], lo[1], lo[2]));
+
+    for (int pass = 0; pass < COLOR_REFINE_PASSES && best.error > 0; ++pass)
+    {
+        uint16_t c0, c1;
+        if (!RefineColors(texels, best, c0, c1))
+        {
+            break;
+        }
+        const ColorFit refined = FitColors(texels, c0, c1);
+        if (refined.error >= best.error)
+        {
+            break;
+        }
+        best = refined;
+    }
+    return best;
+}
+
+void WriteColorBlock(const ColorFit& fit, unsigned char* block)
+{
+    block[0] = fit.c0 & 0xFF;
+    block[1] = fit.c0 >> 8;
+    block[2] = fit.c1 & 0xFF;
+    block[3] = fit.c1 >> 8;
+    for (int i = 0; i < 4; ++i)
+    {
+        block[4 + i] = (fit.indices >> (i * 8)) & 0xFF;
+    }
+}
+
+// One channel of the texels, `stride` bytes apart, between their smallest and
+// largest value in 8 steps.
+void EncodeValueBlock(const unsigned char* values, int stride, unsigned char* block)
+{
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        low = std::min<int>(low, values[i * stride]);
+        high = std::max<int>(high, values[i * stride]);
+    }
+
+    block[0] = static_cast<unsigned char>(high);
+    block[1] = static_cast<unsigned char>(low);
+    std::memset(block + 2, 0, 6);
+    if (low == high)
+    {
+        return;
+    }
+
+    int palette[8];
+    GetValuePalette(high, low, palette);
+    uint64_t indices = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const int value = values[i * stride];
+        int bestError = 256;
+        uint64_t bestIndex = 0;
+
+        for (int k = 0; k < 8; ++k)
+        {
+            const int error = std::abs(value - palette[k]);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestIndex = k;
+            }
+        }
+        indices |= bestIndex << (i * 3);
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+        block[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+}
+
+void EncodeBlock(const unsigned char* texels, BlockFormat format, unsigned char* block)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        WriteColorBlock(FitColorBlock(texels), block);
+        break;
+    case BlockFormat::BC3:
+        EncodeValueBlock(texels + 3, 4, block);
+        WriteColorBlock(FitColorBlock(texels), block + 8);
+        break;
+    case BlockFormat::BC4:
+        EncodeValueBlock(texels, 4, block);
+        break;
+    }
+}
+
+// `alwaysFourColors` for the color block of BC3, which decoders read in 4
+// color mode whatever the order of the endpoints.
+void DecodeColorBlock(const unsigned char* block, bool alwaysFourColors, unsigned char* texels)
+{
+    const uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+    const uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+    const bool fourColors = alwaysFourColors || c0 > c1;
+    int palette[4][3];
+    GetColorPalette(c0, c1, fourColors, palette);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const int index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+        texels[i * 4 + 0] = static_cast<unsigned char>(palette[index][0]);
+        texels[i * 4 + 1] = static_cast<unsigned char>(palette[index][1]);
+        texels[i * 4 + 2] = static_cast<unsigned char>(palette[index][2]);
+        texels[i * 4 + 3] = (!fourColors && index == 3) ? 0 : 255;
+    }
+}
+
+void DecodeValueBlock(const unsigned char* block, unsigned char* values, int stride)
+{
+    int palette[8];
+    GetValuePalette(block[0], block[1], palette);
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        values[i * stride] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+    }
+}
+
+void DecodeBlock(const unsigned char* block, BlockFormat format, unsigned char* texels)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        DecodeColorBlock(block, false, texels);
+        break;
+    case BlockFormat::BC3:
+        DecodeColorBlock(block + 8, true, texels);
+        DecodeValueBlock(block, texels + 3, 4);
+        break;
+    case BlockFormat::BC4:
+        DecodeValueBlock(block, texels, 4);
+        for (int i = 0; i < 16; ++i)
+        {
+            texels[i * 4 + 1] = texels[i * 4];
+            texels[i * 4 + 2] = texels[i * 4];
+            texels[i * 4 + 3] = 255;
+        }
+        break;
+    }
+}
+
+// The 4x4 texels of a block as RGBA, clamped to the edges of the image.
+void FetchBlock(const unsigned char* pixels, uint32_t width, uint32_t height, int channels, uint32_t blockX,
+                uint32_t blockY, unsigned char* texels)
+{
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+        const uint32_t row = std::min(blockY * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; ++x)
+        {
+            const uint32_t column = std::min(blockX * 4 + x, width - 1);
+            const unsigned char* pixel = pixels + (static_cast<std::size_t>(row) * width + column) * channels;
+            unsigned char* texel = texels + (y * 4 + x) * 4;
+            texel[0] = pixel[0];
+            texel[1] = pixel[1];
+            texel[2] = pixel[2];
+            texel[3] = channels == 4 ? pixel[3] : 255;
+        }
+    }
+}
+
+} // namespace
+
+const char* GetBlockFormatName(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        return "BC1";
+    case BlockFormat::BC3:
+        return "BC3";
+    case BlockFormat::BC4:
+        return "BC4";
+    }
+    return "unknown";
+}
+
+std::size_t GetBlockSize(BlockFormat format)
+{
+    return format == BlockFormat::BC3 ? 16 : 8;
+}
+
+std::vector<MipLevel> GetCompressedLevels(uint32_t width, uint32_t height, BlockFormat format)
+{
+    std::vector<MipLevel> levels = GetMipLevels(width, height, 1);
+    std::size_t offset = 0;
+
+    for (MipLevel& level : levels)
+    {
+        level.offset = offset;
+        offset += static_cast<std::size_t>((level.width + 3) / 4) * ((level.height + 3) / 4) * GetBlockSize(format);
+    }
+    return levels;
+}
+
+std::size_t GetCompressedSize(std::span<const MipLevel> levels, BlockFormat format)
+{
+    const MipLevel& last = levels.back();
+    return last.offset +
+           static_cast<std::size_t>((last.width + 3) / 4) * ((last.height + 3) / 4) * GetBlockSize(format);
+}
+
+BlockFormat ChooseBlockFormat(const unsigned char* pixels, std::size_t pixelCount, int channels)
+{
+    bool gray = true;
+
+    for (std::size_t i = 0; i < pixelCount; ++i)
+    {
+        const unsigned char* pixel = pixels + i * channels;
+        if (channels == 4 && pixel[3] != 255)
+        {
+            return BlockFormat::BC3;
+        }
+        gray = gray && pixel[0] == pixel[1] && pixel[1] == pixel[2];
+    }
+    return gray ? BlockFormat::BC4 : BlockFormat::BC1;
+}
+
+void CompressImage(const unsigned char* pixels, uint32_t width, uint32_t height, int channels, BlockFormat format,
+                   unsigned char* blocks, unsigned int threadCount)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const std::size_t blockSize = GetBlockSize(format);
+
+    const auto compressRows = [&](uint32_t begin, uint32_t end) {
+        unsigned char texels[64];
+        for (uint32_t blockY = begin; blockY < end; ++blockY)
+        {
+            for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+            {
+                FetchBlock(pixels, width, height, channels, blockX, blockY, texels);
+                EncodeBlock(texels, format, blocks + (static_cast<std::size_t>(blockY) * blocksX + blockX) * blockSize);
+            }
+        }
+    };
+
+    const std::size_t blockCount = static_cast<std::size_t>(blocksX) * blocksY;
+    const uint32_t workers = static_cast<uint32_t>(
+        std::max<std::size_t>(std::min<std::size_t>({threadCount, blocksY, blockCount / MIN_BLOCKS_PER_THREAD}), 1));
+    const uint32_t rowsPerWorker = (blocksY + workers - 1) / workers;
+
+    // The calling thread takes the first rows.
+    std::vector<std::thread> threads;
+    for (uint32_t begin = rowsPerWorker; begin < blocksY; begin += rowsPerWorker)
+    {
+        threads.emplace_back(compressRows, begin, std::min(begin + rowsPerWorker, blocksY));
+    }
+    compressRows(0, std::min(rowsPerWorker, blocksY));
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+std::vector<unsigned char> CompressMipChain(const unsigned char* chain, std::span<const MipLevel> levels, int channels,
+                                            BlockFormat format, unsigned int threadCount)
+{
+    const std::vector<MipLevel> compressed = GetCompressedLevels(levels[0].width, levels[0].height, format);
+    std::vector<unsigned char> blocks(GetCompressedSize(compressed, format));
+
+    for (std::size_t i = 0; i < levels.size(); ++i)
+    {
+        CompressImage(chain + levels[i].offset, levels[i].width, levels[i].height, channels, format,
+                      blocks.data() + compressed[i].offset, threadCount);
+    }
+    return blocks;
+}
+
+void DecompressImage(const unsigned char* blocks, uint32_t width, uint32_t height, BlockFormat format,
+                     unsigned char* pixels)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    unsigned char texels[64];
+
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+        {
+            DecodeBlock(blocks + (static_cast<std::size_t>(blockY) * blocksX + blockX) * GetBlockSize(format), format,
+                        texels);
+
+            const uint32_t rows = std::min(4u, height - blockY * 4);
+            const uint32_t columns = std::min(4u, width - blockX * 4);
+            for (uint32_t y = 0; y < rows; ++y)
+            {
+                std::memcpy(pixels + ((static_cast<std::size_t>(blockY) * 4 + y) * width + blockX * 4) * 4,
+                            texels + y * 16, columns * 4);
+            }
+        }
+    }
+}
+
+double ComputePSNR(const unsigned char* original, int channels, const unsigned char* decoded, std::size_t pixelCount)
+{
+    uint64_t squaredError = 0;
+
+    for (std::size_t i = 0; i < pixelCount; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            const int difference = original[i * channels + c] - decoded[i * 4 + c];
+            squaredError += difference * difference;
+        }
+    }
+    if (squaredError == 0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const double meanSquaredError = static_cast<double>(squaredError) / (static_cast<double>(pixelCount) * channels);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,129 @@
+#include "renderer/opengl/FramePrefetcher.hpp"
+#include <algorithm>
+#include <string>
+
+FramePrefetcher::FramePrefetcher(TextureLoader& loader, TextureResidency& residency, std::shared_ptr<MonoVideo> video)
+    : _loader(loader), _residency(residency), _video(std::move(video))
+{
+    for (FrameSlot& slot : _slots)
+    {
+        slot.texture = std::make_shared<TextureOpenGL>();
+        _residency.Add(*slot.texture);
+    }
+}
+
+std::size_t FramePrefetcher::GetDistance(std::size_t frame) const
+{
+    const std::size_t count = _video->GetFrameCount();
+    return (frame + count - _currentFrame) % count;
+}
+
+FramePrefetcher::FrameSlot* FramePrefetcher::FindSlot(std::size_t frame)
+{
+    for (FrameSlot& slot : _slots)
+    {
+        if (slot.frame == frame)
+        {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+// https://stackoverflow.com/questions/6495523/ffmpeg-video-to-opengl-texture
+void FramePrefetcher::Load(std::size_t frame, bool due)
+{
+    FrameSlot* slot = FindSlot(frame);
+
+    if (slot)
+    {
+        // Loaded or loading, unless the residency evicted it since.
+        if (!slot->texture->IsEvicted() || _loader.IsLoading(*slot->texture))
+        {
+            return;
+        }
+    }
+    else
+    {
+        // The pool holds the window and the shown frame, a slot outside both
+        // is always left.
+        const auto free = std::find_if(_slots.begin(), _slots.end(), [this](const FrameSlot& candidate) {
+            return &candidate != &_slots[_shownSlot] &&
+                   (candidate.frame == NO_FRAME || GetDistance(candidate.frame) > FRAME_PREFETCH_WINDOW);
+        });
+        if (free == _slots.end())
+        {
+            return;
+        }
+        slot = &*free;
+    }
+
+    const std::shared_ptr<MonoVideo> video = _video;
+    const uint32_t index = static_cast<uint32_t>(frame);
+
+    _loader.Load("Frame " + std::to_string(frame + 1), video->GetWidth(), video->GetHeight(), 3,
+                 [video, index](unsigned char* pixels) { video->DecodeFrame(index, pixels); }, slot->texture);
+    slot->frame = frame;
+
+    if (due)
+    {
+        ++_demandLoadCount;
+    }
+    else
+    {
+        ++_prefetchCount;
+    }
+}
+
+void FramePrefetcher::Update(std::size_t currentFrame, bool playing)
+{
+    if (!_video)
+    {
+        return;
+    }
+
+    _currentFrame = currentFrame;
+    const std::size_t window = playing ? std::min<std::size_t>(FRAME_PREFETCH_WINDOW, _video->GetFrameCount() - 1) : 0;
+
+    // Loads of frames left behind by a seek, or not needed while paused, would
+    // only hold workers and pixel buffers the next frames need.
+    for (FrameSlot& slot : _slots)
+    {
+        if (slot.frame != NO_FRAME && GetDistance(slot.frame) > window && _loader.IsLoading(*slot.texture))
+        {
+            _loader.Cancel(*slot.texture);
+            slot.frame = NO_FRAME;
+            ++_cancelCount;
+        }
+    }
+
+    // In order, the loader starts them first come first served.
+    Load(_currentFrame, true);
+    for (std::size_t i = 1; i <= window; ++i)
+    {
+        Load((_currentFrame + i) % _video->GetFrameCount(), false);
+    }
+
+    // Frames waiting to be shown count as used, the ones already shown are the
+    // first evicted.
+    for (const FrameSlot& slot : _slots)
+    {
+        if (slot.frame != NO_FRAME && GetDistance(slot.frame) <= window)
+        {
+            _residency.Touch(*slot.texture);
+        }
+    }
+}
+
+// Load never gives the shown slot another frame, the last ready frame stays
+// intact until the current one replaces it.
+const ITexture& FramePrefetcher::GetShownFrame()
+{
+    const FrameSlot* current = _video ? FindSlot(_currentFrame) : nullptr;
+
+    if (current && !_loader.IsLoading(*current->texture) && !current->texture->IsEvicted())
+    {
+        _shownSlot = current - _slots.data();
+    }
+    return *_slots[_shownSlot].texture;
+}
@@ -1,11 +1,16 @@
 #include "renderer/opengl/IndexBuffer.hpp"
 #include "renderer/opengl/RendererOpenGL.hpp"
 
-IndexBuffer::IndexBuffer(const unsigned int *data, unsigned int count) : _count(count) {
+IndexBuffer::IndexBuffer(const unsigned int *data, unsigned int count) : _count(count), _type(GL_UNSIGNED_INT) {
     GlCall(glGenBuffers(1, &_rendererId));
     GlCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _rendererId));
     GlCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
 }
+IndexBuffer::IndexBuffer(const uint16_t *data, unsigned int count) : _count(count), _type(GL_UNSIGNED_SHORT) {
+    GlCall(glGenBuffers(1, &_rendererId));
+    GlCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _rendererId));
+    GlCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(uint16_t), data, GL_STATIC_DRAW));
+}
 IndexBuffer::~IndexBuffer() {
     GlCall(glDeleteBuffers(1, &_rendererId));
 }
@@ -16,3 +21,19 @@ void IndexBuffer::Bind() const {
 void IndexBuffer::Unbind() const {
     GlCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 }
+
+std::vector<uint32_t> IndexBuffer::Read() const {
+    std::vector<uint32_t> indices(_count);
+
+    // Not the element array binding, which belongs to the bound vertex array.
+    GlCall(glBindBuffer(GL_COPY_READ_BUFFER, _rendererId));
+    if (_type == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> shortIndices(_count);
+        GlCall(glGetBufferSubData(GL_COPY_READ_BUFFER, 0, _count * sizeof(uint16_t), shortIndices.data()));
+        indices.assign(shortIndices.begin(), shortIndices.end());
+    } else {
+        GlCall(glGetBufferSubData(GL_COPY_READ_BUFFER, 0, _count * sizeof(uint32_t), indices.data()));
+    }
+    GlCall(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    return indices;
+}
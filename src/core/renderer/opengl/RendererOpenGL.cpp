@@ -8,9 +8,13 @@
 
 #include "SDL3/SDL_video.h"
 
+#include <algorithm>
 #include <alloca.h>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <string>
+#include <thread>
 #include <vector>
 
 static Uint64 lastTime = SDL_GetPerformanceCounter();
@@ -33,8 +37,6 @@ bool GlLogCall(const char* function, const char* file, unsigned int line)
 
 RendererOpenGL::RendererOpenGL(Window& window) : _window(window)
 {
-    _badAppleFrames.resize(6572);
-
     _GLContext = SDL_GL_CreateContext(window.GetSDLWindow());
 
     if (!_GLContext)
@@ -53,10 +55,32 @@ RendererOpenGL::RendererOpenGL(Window& window) : _window(window)
     }
 
     std::cout << "Using Renderer: " << glGetString(GL_RENDERER) << " " << glGetString(GL_VERSION) << "\n";
+
+    _textureLoader = std::make_unique<TextureLoader>(std::thread::hardware_concurrency());
+
+    try
+    {
+        const std::filesystem::path videoPath =
+            std::filesystem::path(ASSET_DIR) / "textures" / (std::string("bad_apple") + MONO_VIDEO_EXTENSION);
+        _badAppleVideo = std::make_shared<MonoVideo>(videoPath.string());
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "Warning: Bad Apple disabled: " << error.what() << "\n";
+    }
+    // The frame rate of the video, 30 like Bad Apple without one.
+    _mediaScheduler = _badAppleVideo ? std::make_unique<MediaScheduler>(_badAppleVideo->GetFrameRate(),
+                                                                        _badAppleVideo->GetFrameCount())
+                                     : std::make_unique<MediaScheduler>(30.0, 1);
+    _framePrefetcher = std::make_unique<FramePrefetcher>(*_textureLoader, _textureResidency, _badAppleVideo);
 }
 
 RendererOpenGL::~RendererOpenGL()
 {
+    // Its workers write to mapped buffers, which must be unmapped while the
+    // context exists.
+    _framePrefetcher.reset();
+    _textureLoader.reset();
     SDL_GL_DestroyContext(_GLContext);
 }
 
@@ -82,21 +106,469 @@ Matrix4 RendererOpenGL::GetFinalMatrix(RotationAxis activeAxis, const Matrix4& a
     return accumulatedRotationMatrix * rotationMatrix;
 }
 
-// https://stackoverflow.com/questions/6495523/ffmpeg-video-to-opengl-texture
-void RendererOpenGL::LoadFrameIfNeeded(std::size_t frameIndex)
+namespace
+{
+
+// https://en.wikipedia.org/wiki/Half-precision_floating-point_format
+// Round to nearest even, like the GPU does when it converts the other way.
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+    {
+        // Infinity or NaN.
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    if (exponent >= 0x1f)
+    {
+        return sign | 0x7c00;
+    }
+    if (exponent <= 0)
+    {
+        // Too small for a normal half, store a subnormal or zero.
+        if (exponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        const uint32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+        {
+            ++half;
+        }
+        return sign | half;
+    }
+
+    // A carry out of the mantissa correctly bumps the exponent.
+    uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        ++half;
+    }
+    return half;
+}
+
+inline uint16_t FloatToUnorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline Vector3 TransformPoint(const Matrix4& matrix, const Vector3& p)
+{
+    const auto& m = matrix._m;
+    return Vector3(m[0][0] * p.x + m[1][0] * p.y + m[2][0] * p.z + m[3][0],
+                   m[0][1] * p.x + m[1][1] * p.y + m[2][1] * p.z + m[3][1],
+                   m[0][2] * p.x + m[1][2] * p.y + m[2][2] * p.z + m[3][2]);
+}
+
+} // namespace
+
+void RendererOpenGL::UploadModel(std::unique_ptr<Model> model)
+{
+    const std::span<const float> vertices = model->GetVertexData();
+    const std::span<const uint32_t> indices = model->GetIndexData();
+    const std::size_t vertexCount = vertices.size() / 5;
+
+    VertexBufferLayout layout;
+
+    if (_vertexFormat == VertexFormat::FLOAT)
+    {
+        // The default. When the model comes from its mesh cache, the vertices and
+        // indices point straight into the mapped file and the driver copies them
+        // without any intermediate buffer.
+        _vb = std::make_unique<VertexBuffer>(vertices.data(), vertices.size_bytes());
+        _positionDecode = Matrix4(1.0f);
+
+        // The first 3 float are the positions, the next 2 the texture coordinates.
+        layout.Push(GL_FLOAT, 3);
+        layout.Push(GL_FLOAT, 2);
+    }
+    else
+    {
+        // Quantized formats encode a copy of the vertices on every load, cache
+        // hits included, for a smaller buffer on the GPU.
+        const bool halfFloat = _vertexFormat == VertexFormat::HALF_FLOAT;
+        const Vector3& min = model->_boundsMin;
+        const Vector3& max = model->_boundsMax;
+
+        // UNORM16 maps the bounds to [0, 1]. Half floats are the most precise
+        // around 0, so they map the bounds to [-1, 1] around their center.
+        const auto extent = [](float low, float high, float divisor) {
+            return high > low ? (high - low) / divisor : 1.0f;
+        };
+        const Vector3 scale = halfFloat ? Vector3(extent(min.x, max.x, 2.0f), extent(min.y, max.y, 2.0f),
+                                                  extent(min.z, max.z, 2.0f))
+                                        : Vector3(extent(min.x, max.x, 1.0f), extent(min.y, max.y, 1.0f),
+                                                  extent(min.z, max.z, 1.0f));
+        const Vector3 offset = halfFloat
+                                   ? Vector3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f)
+                                   : min;
+
+        // Normalized texture coordinates cannot go outside [0, 1], models relying
+        // on GL_REPEAT keep them as half floats.
+        bool uvInRange = true;
+        for (std::size_t i = 0; i < vertexCount && uvInRange; ++i)
+        {
+            const float u = vertices[i * 5 + 3];
+            const float v = vertices[i * 5 + 4];
+            uvInRange = u >= 0.0f && u <= 1.0f && v >= 0.0f && v <= 1.0f;
+        }
+
+        const auto encodePosition = [halfFloat](float value) {
+            return halfFloat ? FloatToHalf(value) : FloatToUnorm16(value);
+        };
+        const auto encodeUV = [uvInRange](float value) {
+            return uvInRange ? FloatToUnorm16(value) : FloatToHalf(value);
+        };
+
+        // x, y, z, w, u, v: the w component keeps every attribute 4-byte aligned
+        // and is decoded as 1.
+        std::vector<uint16_t> packed(vertexCount * 6);
+        for (std::size_t i = 0; i < vertexCount; ++i)
+        {
+            const float* vertex = &vertices[i * 5];
+            uint16_t* out = &packed[i * 6];
+
+            out[0] = encodePosition((vertex[0] - offset.x) / scale.x);
+            out[1] = encodePosition((vertex[1] - offset.y) / scale.y);
+            out[2] = encodePosition((vertex[2] - offset.z) / scale.z);
+            out[3] = encodePosition(1.0f);
+            out[4] = encodeUV(vertex[3]);
+            out[5] = encodeUV(vertex[4]);
+        }
+
+        _vb = std::make_unique<VertexBuffer>(packed.data(), packed.size() * sizeof(uint16_t));
+        _positionDecode = Matrix4::scale(scale) * Matrix4::translation(offset);
+
+        layout.Push(halfFloat ? GL_HALF_FLOAT : GL_UNSIGNED_SHORT, 4, !halfFloat);
+        layout.Push(uvInRange ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT, 2, uvInRange);
+    }
+
+    // Narrowed along with the vertices, the float path uploads the indices as
+    // they are.
+    if (_vertexFormat != VertexFormat::FLOAT && vertexCount <= 65536)
+    {
+        const std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        _ib = std::make_unique<IndexBuffer>(shortIndices.data(), shortIndices.size());
+    }
+    else
+    {
+        _ib = std::make_unique<IndexBuffer>(indices.data(), indices.size());
+    }
+
+    layout.Apply();
+
+    _submeshVisible.assign(model->GetSubmeshes().size(), true);
+    UploadMaterials(*model);
+
+    std::cout << "Model uploaded: " << vertexCount << " vertices of " << layout.GetStride() << " bytes, "
+              << _ib->getCount() << (_ib->getType() == GL_UNSIGNED_SHORT ? " 16-bit" : " 32-bit") << " indices\n";
+
+    // The GPU has its own copy now, only the tables used to draw stay.
+    _mesh = std::make_unique<Mesh>(std::move(*model));
+    SetModelCenter(_mesh->GetCentroid());
+
+    // Points and lines of the previous model, or a streamed one drawn with the
+    // polygon mode.
+    _pointIB.reset();
+    _lineIB.reset();
+    ApplyRenderMode();
+}
+
+void RendererOpenGL::UploadMaterials(const Model& model)
+{
+    if (model.GetMaterials().empty())
+    {
+        _materialTextures.reset();
+        _layerVB.reset();
+        GlCall(glDisableVertexAttribArray(2));
+        return;
+    }
+
+    _materialTextures = std::make_unique<TextureArrayOpenGL>(model.GetMaterials());
+
+    // Submeshes of different materials never share a vertex, and coarser levels
+    // only use vertices of the first one.
+    const std::size_t vertexCount = model.GetVertexData().size() / 5;
+    const std::span<const uint32_t> indices = model.GetIndexData();
+    std::vector<uint16_t> layers(vertexCount, _materialTextures->GetLayer(NO_MATERIAL));
+
+    for (std::size_t s = 0; s < model.GetSubmeshes().size(); ++s)
+    {
+        const MeshRange& range = model.GetSubmeshRange(0, s);
+        const uint16_t layer = _materialTextures->GetLayer(model.GetSubmeshMaterialIndex(s));
+
+        for (uint32_t i = range.indexOffset; i < range.indexOffset + range.indexCount; ++i)
+        {
+            layers[indices[i]] = layer;
+        }
+    }
+
+    _layerVB = std::make_unique<VertexBuffer>(layers.data(), layers.size() * sizeof(uint16_t));
+
+    VertexBufferLayout layout;
+    layout.Push(GL_UNSIGNED_SHORT, 1);
+    layout.Apply(2);
+}
+
+const MeshLod& RendererOpenGL::SelectLod() const
+{
+    const std::span<const MeshLod> lods = _mesh->GetLods();
+    const Vector3& c = _mesh->GetCentroid();
+    const Vector3& s = _mesh->GetSphereCenter();
+
+    // The model rotates around its centroid, so only the view moves it relative
+    // to the camera.
+    const auto& m = _viewMatrix._m;
+    const float x = m[0][0] * c.x + m[1][0] * c.y + m[2][0] * c.z + m[3][0];
+    const float y = m[0][1] * c.x + m[1][1] * c.y + m[2][1] * c.z + m[3][1];
+    const float z = m[0][2] * c.x + m[1][2] * c.y + m[2][2] * c.z + m[3][2];
+
+    // The bounding sphere, grown to stay around the model in any rotation.
+    const float dx = s.x - c.x;
+    const float dy = s.y - c.y;
+    const float dz = s.z - c.z;
+    const float radius = std::sqrt(dx * dx + dy * dy + dz * dz) + _mesh->GetSphereRadius();
+    const float distance = std::max(std::sqrt(x * x + y * y + z * z) - radius, NEAR_PLANE);
+
+    // Pixels covered by one model unit at the closest point of the bounds.
+    const float pixelsPerUnit = _projectionMatrix._m[1][1] * _window.GetWindowHeight() * 0.5f / distance;
+
+    std::size_t level = 0;
+    while (level + 1 < lods.size() && lods[level + 1].error * pixelsPerUnit <= LOD_PIXEL_ERROR)
+    {
+        ++level;
+    }
+    return lods[level];
+}
+
+bool RendererOpenGL::Pick(float x, float y, PickResult& result) const
+{
+    if (!_mesh || !_mesh->GetBvh())
+    {
+        return false;
+    }
+
+    // View space ray through the pixel, from the camera to the far plane.
+    const float ndcX = 2.0f * x / _window.GetWindowWidth() - 1.0f;
+    const float ndcY = 1.0f - 2.0f * y / _window.GetWindowHeight();
+    const Vector3 viewDirection(ndcX / _projectionMatrix._m[0][0], ndcY / _projectionMatrix._m[1][1], -1.0f);
+
+    // The model and view matrices only rotate and translate, the inverse
+    // rotation is the transpose.
+    const Matrix4 modelViewMatrix = _translateToOrigin * _accumulatedRotationMatrix * _translateBack * _viewMatrix;
+    const auto& m = modelViewMatrix._m;
+    const auto inverseRotate = [&](const Vector3& v) {
+        return Vector3(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z, m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                       m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+    };
+    const Vector3 origin = inverseRotate(Vector3(-m[3][0], -m[3][1], -m[3][2]));
+
+    // The direction has a view depth of 1, so the distance is the depth.
+    if (!_mesh->GetBvh()->Intersect(origin, inverseRotate(viewDirection), FAR_PLANE, result.hit))
+    {
+        return false;
+    }
+    result.submesh = _mesh->FindSubmesh(result.hit.triangle);
+    return true;
+}
+
+bool RendererOpenGL::IsSphereInFrustum(const Vector3& viewCenter, float radius) const
+{
+    // Side planes of the frustum in view space all pass through the camera, the
+    // projection gives their slope.
+    const float px = _projectionMatrix._m[0][0];
+    const float py = _projectionMatrix._m[1][1];
+    const float normalizeX = 1.0f / std::sqrt(px * px + 1.0f);
+    const float normalizeY = 1.0f / std::sqrt(py * py + 1.0f);
+    const float x = viewCenter.x;
+    const float y = viewCenter.y;
+    const float z = viewCenter.z;
+
+    return z - radius <= -NEAR_PLANE && -z - radius <= FAR_PLANE && (px * x + z) * normalizeX <= radius &&
+           (-px * x + z) * normalizeX <= radius && (py * y + z) * normalizeY <= radius &&
+           (-py * y + z) * normalizeY <= radius;
+}
+
+void RendererOpenGL::AddDrawRange(uint32_t indexOffset, uint32_t indexCount)
+{
+    const std::size_t indexSize = _ib->getType() == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    const uintptr_t offset = indexOffset * indexSize;
+
+    // Ranges following each other in the index buffer share one draw.
+    if (!_drawCounts.empty() &&
+        reinterpret_cast<uintptr_t>(_drawOffsets.back()) + _drawCounts.back() * indexSize == offset)
+    {
+        _drawCounts.back() += indexCount;
+        return;
+    }
+    _drawCounts.push_back(indexCount);
+    _drawOffsets.push_back(reinterpret_cast<const void*>(offset));
+}
+
+void RendererOpenGL::AddCluster(std::size_t cluster, uint32_t indexOffset, uint32_t indexCount)
+{
+    _stats.trianglesDrawn += indexCount / 3;
+
+    switch (_renderMode)
+    {
+    case RenderMode::POINT:
+        AddDrawRange(_pointRanges[cluster].offset, _pointRanges[cluster].count);
+        _stats.primitivesDrawn += _pointRanges[cluster].count;
+        break;
+    case RenderMode::LINE:
+        AddDrawRange(_lineRanges[cluster].offset, _lineRanges[cluster].count);
+        _stats.primitivesDrawn += _lineRanges[cluster].count / 2;
+        break;
+    case RenderMode::FILL:
+        AddDrawRange(indexOffset, indexCount);
+        _stats.primitivesDrawn += indexCount / 3;
+        break;
+    }
+}
+
+void RendererOpenGL::CullSubmeshes(std::size_t level, const Matrix4& modelViewMatrix)
+{
+    const std::span<const Submesh> submeshes = _mesh->GetSubmeshes();
+
+    _drawCounts.clear();
+    _drawOffsets.clear();
+
+    for (std::size_t s = 0; s < submeshes.size(); ++s)
+    {
+        const MeshRange& range = _mesh->GetSubmeshRange(level, s);
+        const uint32_t trianglesBefore = _stats.trianglesDrawn;
+
+        if (_submeshVisible[s])
+        {
+            // The bounding sphere of the submesh box, in view space.
+            const Vector3& min = submeshes[s].boundsMin;
+            const Vector3& max = submeshes[s].boundsMax;
+            const Vector3 center((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+            const float dx = max.x - min.x;
+            const float dy = max.y - min.y;
+            const float dz = max.z - min.z;
+
+            if (IsSphereInFrustum(TransformPoint(modelViewMatrix, center),
+                                  0.5f * std::sqrt(dx * dx + dy * dy + dz * dz)))
+            {
+                if (range.meshletCount > 0)
+                {
+                    CullMeshlets(range, modelViewMatrix);
+                }
+                else
+                {
+                    AddCluster(_mesh->GetMeshlets().size() + level * submeshes.size() + s, range.indexOffset,
+                               range.indexCount);
+                }
+            }
+        }
+
+        if (_stats.trianglesDrawn > trianglesBefore)
+        {
+            ++_stats.partsDrawn;
+        }
+        else
+        {
+            ++_stats.partsSkipped;
+        }
+    }
+}
+
+void RendererOpenGL::CullMeshlets(const MeshRange& range, const Matrix4& modelViewMatrix)
 {
-    if (!_badAppleFrames[frameIndex])
+    const std::span<const Meshlet> meshlets = _mesh->GetMeshlets().subspan(range.meshletOffset, range.meshletCount);
+    const auto& m = modelViewMatrix._m;
+
+    for (std::size_t i = 0; i < meshlets.size(); ++i)
     {
-        std::filesystem::path path =
-            std::filesystem::path(ASSET_DIR) / "textures" / "bad_apple" / (std::to_string(frameIndex + 1) + ".tga");
+        const Meshlet& meshlet = meshlets[i];
+        ++_stats.clustersTested;
+
+        // View space, the camera sits at the origin and looks down -z.
+        const Vector3 c = TransformPoint(modelViewMatrix, meshlet.center);
+        const Vector3& a = meshlet.coneAxis;
+        const float ax = m[0][0] * a.x + m[1][0] * a.y + m[2][0] * a.z;
+        const float ay = m[0][1] * a.x + m[1][1] * a.y + m[2][1] * a.z;
+        const float az = m[0][2] * a.x + m[1][2] * a.y + m[2][2] * a.z;
+
+        if (c.x * ax + c.y * ay + c.z * az >=
+            meshlet.coneCutoff * std::sqrt(c.x * c.x + c.y * c.y + c.z * c.z) + meshlet.radius)
+        {
+            ++_stats.clustersBackfacing;
+            continue;
+        }
+
+        if (!IsSphereInFrustum(c, meshlet.radius))
+        {
+            ++_stats.clustersOutside;
+            continue;
+        }
 
-        _badAppleFrames[frameIndex] = std::make_unique<TextureOpenGL>(path);
+        AddCluster(range.meshletOffset + i, meshlet.indexOffset, meshlet.indexCount);
     }
 }
 
+void RendererOpenGL::SetModelCenter(const Vector3& center)
+{
+    _translateToOrigin = Matrix4::translation(-center);
+    _translateBack = Matrix4::translation(center);
+}
+
+void RendererOpenGL::PollStream()
+{
+    GlCall(glBindVertexArray(_VAO));
+
+    // The finished model replaces the streamed buffers.
+    if (std::unique_ptr<Model> model = _stream->TakeModel())
+    {
+        _stream.reset();
+        _streamBatches.clear();
+
+        UploadModel(std::move(model));
+
+        _streamVB.reset();
+        _streamIB.reset();
+        _streamIndexCount = 0;
+        return;
+    }
+
+    _stream->Poll(_streamBatches);
+
+    for (const MeshBatch& batch : _streamBatches)
+    {
+        if (_streamVB->Append(batch.vertices.data(), batch.vertices.size() * sizeof(float)))
+        {
+            _streamVB->Bind();
+            VertexBufferLayout layout;
+            layout.Push(GL_FLOAT, 3);
+            layout.Push(GL_FLOAT, 2);
+            layout.Apply();
+        }
+        if (_streamIB->Append(batch.indices.data(), batch.indices.size() * sizeof(uint32_t)))
+        {
+            _streamIB->Bind();
+        }
+
+        _streamIndexCount += batch.indices.size();
+        SetModelCenter(batch.centroid);
+    }
+    _streamBatches.clear();
+}
+
 void RendererOpenGL::Start()
 {
-    if (!_model)
+    if (!_model && !_stream)
     {
         throw std::runtime_error("Renderer: model not set");
     }
@@ -120,31 +592,35 @@ void RendererOpenGL::Start()
     GlCall(glGenVertexArrays(1, &_VAO));
     GlCall(glBindVertexArray(_VAO));
 
-    _vb = std::make_unique<VertexBuffer>(_model->_vertexBuffer.data(), _model->_vertexBuffer.size() * sizeof(float));
-    _ib = std::make_unique<IndexBuffer>(_model->_verticesIndices.data(), _model->_verticesIndices.size());
-
-    // Set up vertex attribute pointers. The first 3 float are the positions.
-    // Vertex positions (attribute 0) on shader.
-    GlCall(glEnableVertexAttribArray(0));
-    GlCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(0)));
-
-    // The next 2 float are the texture coordinates.
-    // Texture coordinates (attribute 1) on shader.
-    GlCall(glEnableVertexAttribArray(1));
-    GlCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(3 * sizeof(float))));
+    if (_model)
+    {
+        UploadModel(std::move(_model));
+    }
+    else
+    {
+        _streamVB = std::make_unique<StreamBuffer>(GL_ARRAY_BUFFER, STREAM_BUFFER_CAPACITY);
+        _streamIB = std::make_unique<StreamBuffer>(GL_ELEMENT_ARRAY_BUFFER, STREAM_BUFFER_CAPACITY);
+        _streamIB->Bind();
+        _streamVB->Bind();
+
+        VertexBufferLayout layout;
+        layout.Push(GL_FLOAT, 3);
+        layout.Push(GL_FLOAT, 2);
+        layout.Apply();
+    }
 
     _texture->Bind();
     _noiseTexture->Bind(1);
 
-    _projectionMatrix = Matrix4::perspective(45.0f, _window.GetWindowWidth(), _window.GetWindowHeight(), 0.1f, 1000.0f);
-    _translateToOrigin = Matrix4::translation(-_model->_centroid);
-    _translateBack = Matrix4::translation(_model->_centroid);
+    _projectionMatrix =
+        Matrix4::perspective(45.0f, _window.GetWindowWidth(), _window.GetWindowHeight(), NEAR_PLANE, FAR_PLANE);
 
     std::filesystem::path shaderPath = std::filesystem::path(ASSET_DIR) / "shader" / "Basic.glsl";
     _shader = std::make_unique<ShaderOpenGL>(shaderPath);
     _shader->Bind();
     _shader->SetUniform1i("u_Texture", 0);
     _shader->SetUniform1i("u_DissolveTexture", 0);
+    _shader->SetUniform1i("u_Materials", 2);
     _shader->SetUniformMat4f("u_ViewMatrix", _viewMatrix);
     _shader->SetUniformMat4f("u_ProjectionMatrix", _projectionMatrix);
 
@@ -164,18 +640,20 @@ void RendererOpenGL::Start()
     _quadVB = std::make_unique<VertexBuffer>(quadVertices, sizeof(quadVertices));
     _quadIB = std::make_unique<IndexBuffer>(quadIndices, 6);
 
-    GlCall(glEnableVertexAttribArray(0));
-    GlCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0));
-
-    GlCall(glEnableVertexAttribArray(1));
-    GlCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float))));
-
-    LoadFrameIfNeeded(_currentFrame);
+    VertexBufferLayout quadLayout;
+    quadLayout.Push(GL_FLOAT, 3);
+    quadLayout.Push(GL_FLOAT, 2);
+    quadLayout.Apply();
 }
 
 void RendererOpenGL::Update(float deltaTime, Camera& camera)
 {
-    _frameTimer += deltaTime;
+    _textureLoader->Update();
+
+    if (_stream)
+    {
+        PollStream();
+    }
 
     if (_transitioning)
     {
@@ -216,19 +694,9 @@ void RendererOpenGL::Update(float deltaTime, Camera& camera)
         }
     }
 
-    while (_frameTimer >= FRAME_TIME)
-    {
-        _frameTimer -= FRAME_TIME;
-
-        _currentFrame++;
-
-        if (_currentFrame >= _badAppleFrames.size())
-        {
-            _currentFrame = 0;
-        }
-
-        LoadFrameIfNeeded(_currentFrame);
-    }
+    const std::size_t frame = _mediaScheduler->Update(deltaTime);
+    _framePrefetcher->Update(frame, _mediaScheduler->IsPlaying());
+    _textureResidency.Trim();
 
     _viewMatrix = Matrix4::rotationY(camera.rotationAngle) * Matrix4::translation(-camera.pos);
     _accumulatedRotationMatrix = GetFinalMatrix(_activeAxis, _accumulatedRotationMatrix);
@@ -245,36 +713,107 @@ void RendererOpenGL::Render()
     GlCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
     Matrix4 modelMatrix = _translateToOrigin * _accumulatedRotationMatrix * _translateBack;
+    const ITexture& badAppleFrame = _framePrefetcher->GetShownFrame();
+    if (_badAppleVideo)
+    {
+        _mediaScheduler->Present(_framePrefetcher->GetShownFrameNumber());
+    }
+    _stats = RenderStats();
+    _stats.textureBytes = _textureResidency.GetUsedBytes();
+    _stats.textureBudget = _textureResidency.GetBudget();
+    _stats.textureEvictions = _textureResidency.GetEvictionCount();
+    _stats.textureReloads = _textureResidency.GetReloadCount();
+    _stats.framesPrefetched = _framePrefetcher->GetPrefetchCount();
+    _stats.frameDemandLoads = _framePrefetcher->GetDemandLoadCount();
+    _stats.frameLoadsCancelled = _framePrefetcher->GetCancelCount();
+    _stats.framesDropped = _mediaScheduler->GetDroppedCount();
+    _stats.framesLate = _mediaScheduler->GetLateCount();
+    _stats.framesRepeated = _mediaScheduler->GetRepeatedCount();
+    _stats.audioClock = _mediaScheduler->GetClock() == MediaClock::AUDIO;
 
     if (!_useBadAppleOnModel)
     {
         GlCall(glDisable(GL_DEPTH_TEST));
         GlCall(glBindVertexArray(_quadVAO));
         _quadShader->Bind();
-        _badAppleFrames[_currentFrame]->Bind();
+        badAppleFrame.Bind();
         GlCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr));
         GlCall(glEnable(GL_DEPTH_TEST));
+        ++_stats.textureBinds;
+        ++_stats.drawCalls;
     }
 
     _shader->Bind();
 
+    // All the materials of the model are in one texture array, bound once
+    // whatever the number of parts drawn.
+    const bool useMaterials = _mesh && _materialTextures && !_useBadAppleOnModel;
+
     if (_useBadAppleOnModel)
     {
-        _badAppleFrames[_currentFrame]->Bind();
+        badAppleFrame.Bind();
+    }
+    else if (useMaterials)
+    {
+        _materialTextures->Bind(2);
     }
     else
     {
         _texture->Bind();
     }
+    ++_stats.textureBinds;
 
+    _shader->SetUniform1i("u_UseMaterials", useMaterials);
     _shader->SetUniform1f("u_ModeFactor", _blendFactor);
     _shader->SetUniform1f("u_DissolveAmount", _dissolveAmount);
     _shader->SetUniformMat4f("u_ViewMatrix", _viewMatrix);
-    _shader->SetUniformMat4f("u_ModelMatrix", modelMatrix);
+    _shader->SetUniformMat4f("u_ModelMatrix", _positionDecode * modelMatrix);
 
     GlCall(glBindVertexArray(_VAO));
-    _ib->Bind();
-    GlCall(glDrawElements(GL_TRIANGLES, _model->_verticesIndices.size(), GL_UNSIGNED_INT, nullptr));
+
+    if (!_mesh)
+    {
+        ++_stats.drawCalls;
+        _stats.drawRanges = 1;
+        _stats.trianglesDrawn = _streamIndexCount / 3;
+        _stats.primitivesDrawn = _renderMode == RenderMode::FILL ? _streamIndexCount / 3 : _streamIndexCount;
+        GlCall(glDrawElements(GL_TRIANGLES, _streamIndexCount, GL_UNSIGNED_INT, nullptr));
+        return;
+    }
+
+    const MeshLod& lod = SelectLod();
+    CullSubmeshes(&lod - _mesh->GetLods().data(), modelMatrix * _viewMatrix);
+
+    _stats.drawRanges = _drawCounts.size();
+    if (_drawCounts.empty())
+    {
+        return;
+    }
+
+    // The point and line buffers use the index type of the triangles. Binding
+    // them changes the vertex array, which gets its triangles back after. Face
+    // culling does not apply to points and lines, both modes see through the
+    // model apart from the clusters culled whole.
+    GLenum primitive = GL_TRIANGLES;
+    if (_renderMode == RenderMode::POINT)
+    {
+        _pointIB->Bind();
+        primitive = GL_POINTS;
+    }
+    else if (_renderMode == RenderMode::LINE)
+    {
+        _lineIB->Bind();
+        primitive = GL_LINES;
+    }
+
+    ++_stats.drawCalls;
+    GlCall(glMultiDrawElements(primitive, _drawCounts.data(), _ib->getType(), _drawOffsets.data(),
+                               _drawCounts.size()));
+
+    if (primitive != GL_TRIANGLES)
+    {
+        _ib->Bind();
+    }
 }
 
 void RendererOpenGL::SwapBuffers()
@@ -284,16 +823,84 @@ void RendererOpenGL::SwapBuffers()
 
 void RendererOpenGL::SetPolygonMode(RenderMode mode)
 {
-    switch (mode)
+    _renderMode = mode;
+    ApplyRenderMode();
+}
+
+void RendererOpenGL::ApplyRenderMode()
+{
+    // A model still streaming has no tables to build the point and line
+    // buffers from, it is drawn with the polygon mode until it is uploaded.
+    if (!_mesh)
     {
-    case RenderMode::POINT:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
-        break;
-    case RenderMode::LINE:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        break;
-    case RenderMode::FILL:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        break;
+        switch (_renderMode)
+        {
+        case RenderMode::POINT:
+            GlCall(glPolygonMode(GL_FRONT_AND_BACK, GL_POINT));
+            break;
+        case RenderMode::LINE:
+            GlCall(glPolygonMode(GL_FRONT_AND_BACK, GL_LINE));
+            break;
+        case RenderMode::FILL:
+            GlCall(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
+            break;
+        }
+        return;
     }
+
+    GlCall(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
+
+    if ((_renderMode == RenderMode::POINT && !_pointIB) || (_renderMode == RenderMode::LINE && !_lineIB))
+    {
+        BuildTopology();
+    }
+}
+
+void RendererOpenGL::BuildTopology()
+{
+    // Clusters are the meshlets, then the submesh ranges of every level, the
+    // ones split in meshlets are left empty.
+    const std::span<const Meshlet> meshlets = _mesh->GetMeshlets();
+    const std::size_t submeshCount = _mesh->GetSubmeshes().size();
+    std::vector<IndexRange> clusters;
+    clusters.reserve(meshlets.size() + _mesh->GetLods().size() * submeshCount);
+
+    for (const Meshlet& meshlet : meshlets)
+    {
+        clusters.push_back(IndexRange{meshlet.indexOffset, meshlet.indexCount});
+    }
+    for (std::size_t level = 0; level < _mesh->GetLods().size(); ++level)
+    {
+        for (std::size_t s = 0; s < submeshCount; ++s)
+        {
+            const MeshRange& range = _mesh->GetSubmeshRange(level, s);
+            clusters.push_back(IndexRange{range.indexOffset, range.meshletCount > 0 ? 0 : range.indexCount});
+        }
+    }
+
+    const std::vector<uint32_t> triangles = _ib->Read();
+    const bool points = _renderMode == RenderMode::POINT;
+    std::vector<IndexRange>& ranges = points ? _pointRanges : _lineRanges;
+    const std::vector<uint32_t> indices = points ? BuildPointIndices(triangles, clusters, ranges)
+                                                 : BuildLineIndices(triangles, clusters, ranges);
+
+    // Creating a buffer binds it to the vertex array of the model.
+    GlCall(glBindVertexArray(_VAO));
+    std::unique_ptr<IndexBuffer> buffer;
+    if (_ib->getType() == GL_UNSIGNED_SHORT)
+    {
+        const std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        buffer = std::make_unique<IndexBuffer>(shortIndices.data(), shortIndices.size());
+    }
+    else
+    {
+        buffer = std::make_unique<IndexBuffer>(indices.data(), indices.size());
+    }
+    _ib->Bind();
+
+    std::cout << "Built " << (points ? indices.size() : indices.size() / 2) << (points ? " points" : " lines")
+              << " for " << triangles.size() / 3 << " triangles, " << triangles.size()
+              << " with the polygon mode\n";
+
+    (points ? _pointIB : _lineIB) = std::move(buffer);
 }
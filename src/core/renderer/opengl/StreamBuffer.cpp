@@ -0,0 +1,42 @@
+#include "renderer/opengl/StreamBuffer.hpp"
+#include "renderer/opengl/RendererOpenGL.hpp"
+#include <algorithm>
+
+// Writes go through GL_COPY_WRITE_BUFFER, so appending never touches the
+// element buffer binding of the bound VAO.
+StreamBuffer::StreamBuffer(unsigned int target, std::size_t capacity) : _target(target), _size(0), _capacity(capacity) {
+    GlCall(glGenBuffers(1, &_rendererId));
+    GlCall(glBindBuffer(GL_COPY_WRITE_BUFFER, _rendererId));
+    GlCall(glBufferData(GL_COPY_WRITE_BUFFER, _capacity, nullptr, GL_DYNAMIC_DRAW));
+}
+StreamBuffer::~StreamBuffer() {
+    GlCall(glDeleteBuffers(1, &_rendererId));
+}
+
+bool StreamBuffer::Append(const void *data, std::size_t size) {
+    bool replaced = false;
+
+    if (_size + size > _capacity) {
+        unsigned int grown;
+        _capacity = std::max(_capacity * 2, _size + size);
+
+        GlCall(glGenBuffers(1, &grown));
+        GlCall(glBindBuffer(GL_COPY_WRITE_BUFFER, grown));
+        GlCall(glBufferData(GL_COPY_WRITE_BUFFER, _capacity, nullptr, GL_DYNAMIC_DRAW));
+        GlCall(glBindBuffer(GL_COPY_READ_BUFFER, _rendererId));
+        GlCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _size));
+        GlCall(glDeleteBuffers(1, &_rendererId));
+
+        _rendererId = grown;
+        replaced = true;
+    }
+
+    GlCall(glBindBuffer(GL_COPY_WRITE_BUFFER, _rendererId));
+    GlCall(glBufferSubData(GL_COPY_WRITE_BUFFER, _size, size, data));
+    _size += size;
+    return replaced;
+}
+
+void StreamBuffer::Bind() const {
+    GlCall(glBindBuffer(_target, _rendererId));
+}
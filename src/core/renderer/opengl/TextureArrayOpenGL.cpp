@@ -0,0 +1,219 @@
+#include "renderer/opengl/TextureArrayOpenGL.hpp"
+#include "ImageMipmap.hpp"
+#include "ImageTGA.hpp"
+#include "MappedFile.hpp"
+#include "renderer/opengl/RendererOpenGL.hpp"
+#include "renderer/opengl/TextureOpenGL.hpp"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+bool IsTGA(const std::string& path)
+{
+    if (path.size() < 4)
+    {
+        return false;
+    }
+    std::string extension = path.substr(path.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return extension == ".tga";
+}
+
+// Only the header is validated, so the layer size is known before decoding
+// the maps one at a time.
+bool ReadTGASize(const Material& material, uint32_t& width, uint32_t& height)
+{
+    try
+    {
+        const MappedFile file(material.diffuseMap);
+        const TGAInfo info = ReadTGAInfo(reinterpret_cast<const unsigned char*>(file.GetData()), file.GetSize());
+
+        width = info.sizeX;
+        height = info.sizeY;
+        return true;
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "Warning: " << material.diffuseMap << ": " << error.what() << ", " << material.name
+                  << " uses its diffuse color\n";
+        return false;
+    }
+}
+
+bool HasDiffuseMap(const Material& material)
+{
+    if (material.diffuseMap.empty())
+    {
+        return false;
+    }
+    if (!IsTGA(material.diffuseMap))
+    {
+        std::cerr << "Warning: only TGA textures are supported, " << material.name << " uses its diffuse color\n";
+        return false;
+    }
+    return true;
+}
+
+std::optional<tImageTGA> LoadDiffuseMap(const Material& material)
+{
+    try
+    {
+        return LoadTGA(material.diffuseMap);
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "Warning: " << material.diffuseMap << ": " << error.what() << ", " << material.name
+                  << " uses its diffuse color\n";
+        return std::nullopt;
+    }
+}
+
+// Bilinear resampling of an RGB or RGBA image to a RGBA layer.
+void ResampleToLayer(const tImageTGA& image, uint32_t width, uint32_t height, std::vector<unsigned char>& layer)
+{
+    const float scaleX = static_cast<float>(image.sizeX) / width;
+    const float scaleY = static_cast<float>(image.sizeY) / height;
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const float sy = std::clamp((y + 0.5f) * scaleY - 0.5f, 0.0f, image.sizeY - 1.0f);
+        const int y0 = static_cast<int>(sy);
+        const int y1 = std::min(y0 + 1, image.sizeY - 1);
+        const float fy = sy - y0;
+
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float sx = std::clamp((x + 0.5f) * scaleX - 0.5f, 0.0f, image.sizeX - 1.0f);
+            const int x0 = static_cast<int>(sx);
+            const int x1 = std::min(x0 + 1, image.sizeX - 1);
+            const float fx = sx - x0;
+
+            unsigned char* out = &layer[(y * width + x) * 4];
+            for (int c = 0; c < 4; ++c)
+            {
+                if (c >= image.channels)
+                {
+                    out[c] = 255;
+                    continue;
+                }
+                const auto at = [&](int px, int py) {
+                    return static_cast<float>(image.data[(py * image.sizeX + px) * image.channels + c]);
+                };
+                const float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+                const float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+                out[c] = static_cast<unsigned char>(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+    }
+}
+
+void FillLayer(const Vector3& color, std::vector<unsigned char>& layer)
+{
+    const auto channel = [](float value) {
+        return static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+    for (std::size_t i = 0; i < layer.size(); i += 4)
+    {
+        layer[i + 0] = channel(color.x);
+        layer[i + 1] = channel(color.y);
+        layer[i + 2] = channel(color.z);
+        layer[i + 3] = 255;
+    }
+}
+
+} // namespace
+
+TextureArrayOpenGL::TextureArrayOpenGL(std::span<const Material> materials)
+    : _rendererID(0), _width(1), _height(1), _layerCount(0)
+{
+    GLint maxLayers = 0;
+    GLint maxSize = 0;
+    GlCall(glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers));
+    GlCall(glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize));
+
+    if (materials.size() + 1 > static_cast<std::size_t>(maxLayers))
+    {
+        std::cerr << "Warning: " << materials.size() << " materials, only the first " << maxLayers - 1
+                  << " get their own layer\n";
+        materials = materials.first(maxLayers - 1);
+    }
+    _layerCount = materials.size() + 1;
+
+    std::vector<bool> hasMap(materials.size(), false);
+    for (std::size_t i = 0; i < materials.size(); ++i)
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        if (HasDiffuseMap(materials[i]) && ReadTGASize(materials[i], width, height))
+        {
+            hasMap[i] = true;
+            _width = std::max(_width, width);
+            _height = std::max(_height, height);
+        }
+    }
+
+    const uint32_t maxLayerSize = std::min<uint32_t>(MATERIAL_LAYER_MAX_SIZE, maxSize);
+    _width = std::min(_width, maxLayerSize);
+    _height = std::min(_height, maxLayerSize);
+
+    GlCall(glGenTextures(1, &_rendererID));
+    GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, _rendererID));
+
+    GlCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT));
+    GlCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT));
+
+    // Every layer has the same mip chain, built on the CPU from its level 0.
+    const std::vector<MipLevel> levels = GetMipLevels(_width, _height, 4);
+    for (std::size_t level = 0; level < levels.size(); ++level)
+    {
+        GlCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levels[level].width, levels[level].height,
+                            _layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    }
+    GlCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels.size() - 1));
+    SetTextureFiltering(GL_TEXTURE_2D_ARRAY, true);
+
+    std::vector<unsigned char> layer(GetMipChainSize(levels, 4));
+    for (uint32_t i = 0; i < _layerCount; ++i)
+    {
+        const std::optional<tImageTGA> image = i < hasMap.size() && hasMap[i] ? LoadDiffuseMap(materials[i])
+                                                                                 : std::nullopt;
+        if (image)
+        {
+            ResampleToLayer(*image, _width, _height, layer);
+        }
+        else
+        {
+            FillLayer(i < materials.size() ? materials[i].diffuse : Vector3(1, 1, 1), layer);
+        }
+        BuildMipChain(layer.data(), levels, 4, layer.data());
+
+        for (std::size_t level = 0; level < levels.size(); ++level)
+        {
+            GlCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, i, levels[level].width, levels[level].height, 1,
+                                   GL_RGBA, GL_UNSIGNED_BYTE, layer.data() + levels[level].offset));
+        }
+    }
+
+    GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+
+    std::cout << "Material textures: " << _layerCount << " layers of " << _width << "x" << _height << "\n";
+}
+
+TextureArrayOpenGL::~TextureArrayOpenGL()
+{
+    GlCall(glDeleteTextures(1, &_rendererID));
+}
+
+void TextureArrayOpenGL::Bind(unsigned int slot) const
+{
+    GlCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, _rendererID));
+}
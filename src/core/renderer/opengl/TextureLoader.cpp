@@ -0,0 +1,321 @@
+#include "renderer/opengl/TextureLoader.hpp"
+#include "renderer/opengl/RendererOpenGL.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+TextureLoader::TextureLoader(unsigned int threadCount) : _buffers(TEXTURE_LOADER_MAX_IN_FLIGHT)
+{
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        _threads.emplace_back(&TextureLoader::Work, this);
+    }
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+
+    for (std::thread& thread : _threads)
+    {
+        thread.join();
+    }
+
+    for (PixelBuffer& buffer : _buffers)
+    {
+        if (buffer.id == 0)
+        {
+            continue;
+        }
+        if (buffer.busy)
+        {
+            GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id));
+            GlCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        }
+        GlCall(glDeleteBuffers(1, &buffer.id));
+    }
+    GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+}
+
+std::shared_ptr<TextureOpenGL> TextureLoader::Load(const std::string& path)
+{
+    std::shared_ptr<TextureOpenGL> texture = std::make_shared<TextureOpenGL>();
+    Load(path, texture);
+    return texture;
+}
+
+void TextureLoader::Load(const std::string& path, const std::shared_ptr<TextureOpenGL>& texture)
+{
+    std::unique_ptr<Job> job = std::make_unique<Job>();
+    job->path = path;
+    job->texture = texture;
+    job->target = texture.get();
+    job->ticket = ++_nextTicket;
+    _latestLoads[job->target] = job->ticket;
+    _waiting.push_back(std::move(job));
+}
+
+void TextureLoader::Load(const std::string& name, uint32_t width, uint32_t height, int channels, PixelSource source,
+                         const std::shared_ptr<TextureOpenGL>& texture)
+{
+    Load(name, texture);
+
+    Job& job = *_waiting.back();
+    job.source = std::move(source);
+    job.info.sizeX = width;
+    job.info.sizeY = height;
+    job.info.channels = channels;
+}
+
+bool TextureLoader::IsLatest(const Job& job) const
+{
+    const auto latest = _latestLoads.find(job.target);
+    return latest != _latestLoads.end() && latest->second == job.ticket;
+}
+
+// The texture has nothing left in flight once its last load is done.
+void TextureLoader::Forget(const Job& job)
+{
+    if (IsLatest(job))
+    {
+        _latestLoads.erase(job.target);
+    }
+}
+
+void TextureLoader::Cancel(const TextureOpenGL& texture)
+{
+    if (_latestLoads.erase(&texture) == 0)
+    {
+        return;
+    }
+
+    const auto removed = std::remove_if(_waiting.begin(), _waiting.end(), [&texture](const std::unique_ptr<Job>& job) {
+        return job->target == &texture;
+    });
+    _skippedDecodeCount += _waiting.end() - removed;
+    _waiting.erase(removed, _waiting.end());
+
+    // Jobs no worker took yet hold a mapped buffer, which only Finish, on this
+    // thread, unmaps. Being no longer the latest, they upload nothing.
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _decoding.begin(); it != _decoding.end();)
+    {
+        if ((*it)->target == &texture)
+        {
+            _uploading.push_back(std::move(*it));
+            it = _decoding.erase(it);
+            ++_skippedDecodeCount;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+std::size_t TextureLoader::GetPendingCount() const
+{
+    const std::size_t busy =
+        std::count_if(_buffers.begin(), _buffers.end(), [](const PixelBuffer& buffer) { return buffer.busy; });
+    return _waiting.size() + busy;
+}
+
+void TextureLoader::Update()
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto inBudget = [&]() {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() < TEXTURE_UPLOAD_BUDGET;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::unique_ptr<Job>& job : _decoded)
+        {
+            _uploading.push_back(std::move(job));
+        }
+        _decoded.clear();
+    }
+
+    // Uploads first, they free the buffers the next decodes need.
+    bool first = true;
+    while (!_uploading.empty() && (first || inBudget()))
+    {
+        Finish(*_uploading.front());
+        _uploading.pop_front();
+        first = false;
+    }
+
+    while (!_waiting.empty() && inBudget() && Start(_waiting.front()))
+    {
+        _waiting.pop_front();
+    }
+}
+
+// Return false when every pixel buffer is in use, the job then keeps waiting.
+bool TextureLoader::Start(std::unique_ptr<Job>& job)
+{
+    const auto free = std::find_if(_buffers.begin(), _buffers.end(), [](const PixelBuffer& buffer) {
+        return !buffer.busy;
+    });
+    if (free == _buffers.end())
+    {
+        return false;
+    }
+
+    // Released or loaded again while waiting.
+    if (job->texture.expired() || !IsLatest(*job))
+    {
+        Forget(*job);
+        return true;
+    }
+
+    try
+    {
+        if (!job->source)
+        {
+            job->file = std::make_unique<MappedFile>(job->path);
+            job->info =
+                ReadTGAInfo(reinterpret_cast<const unsigned char*>(job->file->GetData()), job->file->GetSize());
+        }
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "Warning: " << job->path << ": " << error.what() << "\n";
+        Forget(*job);
+        return true;
+    }
+
+    PixelBuffer& buffer = *free;
+    job->levels = GetMipLevels(job->info.sizeX, job->info.sizeY, job->info.channels);
+    const std::size_t size = GetMipChainSize(job->levels, job->info.channels);
+
+    if (buffer.id == 0)
+    {
+        GlCall(glGenBuffers(1, &buffer.id));
+    }
+    GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id));
+
+    // Buffers are reused for the next loads, and only grow.
+    if (buffer.capacity < size)
+    {
+        GlCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+        buffer.capacity = size;
+    }
+
+    // Invalidating lets the driver hand out fresh memory instead of waiting
+    // for the previous upload from this buffer.
+    GlCall(job->pixels = static_cast<unsigned char*>(
+               glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)));
+    GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    if (!job->pixels)
+    {
+        std::cerr << "Warning: " << job->path << ": unable to map a pixel buffer\n";
+        Forget(*job);
+        return true;
+    }
+
+    buffer.busy = true;
+    job->buffer = &buffer;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _decoding.push_back(std::move(job));
+    }
+    _condition.notify_one();
+    return true;
+}
+
+void TextureLoader::Finish(Job& job)
+{
+    GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job.buffer->id));
+
+    // False when the memory was lost while mapped, ex: a mode switch.
+    GLboolean intact = GL_FALSE;
+    GlCall(intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+    job.buffer->busy = false;
+
+    std::shared_ptr<TextureOpenGL> texture = job.texture.lock();
+    if (!texture || !IsLatest(job))
+    {
+        // Released, or loaded again since.
+        Forget(job);
+    }
+    else if (!job.error.empty())
+    {
+        std::cerr << "Warning: " << job.path << ": " << job.error << "\n";
+        Forget(job);
+    }
+    else if (!intact)
+    {
+        std::cerr << "Warning: " << job.path << ": pixel buffer lost, retrying\n";
+        std::unique_ptr<Job> retry = std::make_unique<Job>();
+        retry->path = job.path;
+        retry->source = job.source;
+        retry->info = job.info;
+        retry->texture = job.texture;
+        retry->target = job.target;
+        retry->ticket = job.ticket;
+        _waiting.push_back(std::move(retry));
+    }
+    else
+    {
+        texture->Upload(job.info.sizeX, job.info.sizeY, job.info.channels, nullptr, job.levels);
+        Forget(job);
+        ++_uploadCount;
+    }
+    GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+}
+
+void TextureLoader::Work()
+{
+    std::vector<unsigned char> base;
+
+    while (true)
+    {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stopping || !_decoding.empty(); });
+            if (_stopping)
+            {
+                return;
+            }
+            job = std::move(_decoding.front());
+            _decoding.pop_front();
+        }
+
+        // Level 0 is decoded to memory of our own first: building the other
+        // levels reads it, and reads from the mapped buffer are very slow.
+        try
+        {
+            base.resize(job->info.GetDecodedSize());
+            if (job->source)
+            {
+                job->source(base.data());
+            }
+            else
+            {
+                DecodeTGA(reinterpret_cast<const unsigned char*>(job->file->GetData()), job->file->GetSize(),
+                          job->info, base.data());
+            }
+            std::memcpy(job->pixels, base.data(), base.size());
+            BuildMipChain(base.data(), job->levels, job->info.channels, job->pixels);
+        }
+        catch (const std::runtime_error& error)
+        {
+            job->error = error.what();
+        }
+        job->file.reset();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _decoded.push_back(std::move(job));
+    }
+}
@@ -1,163 +1,323 @@
 #include "renderer/opengl/TextureOpenGL.hpp"
+#include "ImageTGA.hpp"
+#include "TextureCache.hpp"
 #include "renderer/opengl/RendererOpenGL.hpp"
-#include <fstream>
-#include <stdexcept>
-#include <vector>
+#include "renderer/opengl/TextureResidency.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
 
-TextureOpenGL::TextureOpenGL(const std::string& path)
-    : _rendererID(0), _filePath(path), _localBuffer(nullptr), _width(0), _height(0), _BPP(0)
+namespace
 {
-    LoadTGA(path);
 
-    GlCall(glGenTextures(1, &_rendererID));
-    GlCall(glBindTexture(GL_TEXTURE_2D, _rendererID));
+// From the S3TC extension, glad only has the core enums.
+// https://registry.khronos.org/OpenGL/extensions/EXT/EXT_texture_compression_s3tc.txt
+constexpr GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+constexpr GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
 
-    GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-    GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-    // GL REPEAT ensure that if a texture coordinates are not normalized, it will
-    // repeat it seamlessly.
+bool HasExtension(const char* extension)
+{
+    GLint extensionCount = 0;
+    GlCall(glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount));
 
-    GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-    GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+    for (GLint i = 0; i < extensionCount; ++i)
+    {
+        if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), extension) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-    GLenum format = (_BPP == 24) ? GL_RGB : GL_RGBA;
+// Core in 4.6, an extension every driver has before.
+// https://registry.khronos.org/OpenGL/extensions/EXT/EXT_texture_filter_anisotropic.txt
+float GetMaxAnisotropy()
+{
+    static const float maxAnisotropy = []() {
+        const bool supported = GLAD_GL_VERSION_4_6 || HasExtension("GL_EXT_texture_filter_anisotropic") ||
+                               HasExtension("GL_ARB_texture_filter_anisotropic");
+        if (!supported)
+        {
+            return 1.0f;
+        }
 
-    GlCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _width, _height, 0, format, GL_UNSIGNED_BYTE, _localBuffer.get()));
+        GLfloat driverMax = 1.0f;
+        GlCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &driverMax));
+        return std::min(driverMax, TEXTURE_MAX_ANISOTROPY);
+    }();
+    return maxAnisotropy;
+}
 
-    GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+// Compress every level, and report the speed of the encoder and the quality
+// of level 0.
+std::vector<unsigned char> CompressTexture(const std::string& path, const tImageTGA& image,
+                                           std::span<const MipLevel> levels, BlockFormat format)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<unsigned char> blocks = CompressMipChain(image.data.data(), levels, image.channels, format,
+                                                         std::max(std::thread::hardware_concurrency(), 1u));
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const std::size_t pixelCount = static_cast<std::size_t>(image.sizeX) * image.sizeY;
+    std::vector<unsigned char> decoded(pixelCount * 4);
+    DecompressImage(blocks.data(), image.sizeX, image.sizeY, format, decoded.data());
+
+    std::cout << "Compressed " << path << ": " << GetBlockFormatName(format) << ", "
+              << GetMipChainSize(levels, 1) / 1e6 / elapsed.count() << " Mpix/s, PSNR "
+              << ComputePSNR(image.data.data(), image.channels, decoded.data(), pixelCount) << " dB, "
+              << GetMipChainSize(levels, image.channels) / 1024 << " KiB -> " << blocks.size() / 1024 << " KiB\n";
+    return blocks;
 }
 
-TextureOpenGL::~TextureOpenGL()
+} // namespace
+
+void SetTextureFiltering(unsigned int target, bool mipmapped)
 {
+    GlCall(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GlCall(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+    const float anisotropy = mipmapped ? GetMaxAnisotropy() : 1.0f;
+    if (anisotropy > 1.0f)
+    {
+        GlCall(glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY, anisotropy));
+    }
 }
 
-void TextureOpenGL::Bind(unsigned int slot) const
+bool IsBlockFormatSupported(BlockFormat format)
 {
-    GlCall(glActiveTexture(GL_TEXTURE0 + slot));
-    GlCall(glBindTexture(GL_TEXTURE_2D, _rendererID));
+    static const bool s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+    return format == BlockFormat::BC4 ? GLAD_GL_VERSION_3_0 : s3tc;
 }
 
-void TextureOpenGL::Unbind()
+TextureOpenGL::TextureOpenGL(const std::string& path) : TextureOpenGL()
 {
+    _filePath = path;
+    Load();
 }
 
-// https://www.ryanjuckett.com/parsing-colors-in-a-tga-file/
-// https://www.gamers.org/dEngine/quake3/TGA.txt
-void TextureOpenGL::LoadTGA(const std::string& filename)
+void TextureOpenGL::Load()
 {
-    std::ifstream file(filename, std::ios::binary);
+    const std::string& path = _filePath;
+
+    // Hashing the TGA tells a stale cache apart far quicker than decoding it.
+    const MappedFile source(path);
+    const MeshCacheKey key = MeshCache::MakeKey(path, source);
+    const std::unique_ptr<TextureCache> cache = TextureCache::Open(path, key);
 
-    if (!file.is_open())
+    if (cache && IsBlockFormatSupported(cache->GetFormat()))
     {
-        throw std::runtime_error("Error: unable to load TGA File!");
+        const TextureCacheHeader& header = cache->GetHeader();
+        UploadCompressed(header.width, header.height, cache->GetFormat(), cache->GetBlocks().data(),
+                         cache->GetLevels());
+        return;
     }
 
-    unsigned char length = 0;
-    unsigned char imageType = 0;
-    unsigned char bits = 0;
-    unsigned short width = 0, height = 0;
-
-    file.read(reinterpret_cast<char*>(&length), sizeof(length));
-    file.seekg(1, std::ios::cur);
-    file.read(reinterpret_cast<char*>(&imageType), sizeof(imageType));
-    file.seekg(9, std::ios::cur);
-    file.read(reinterpret_cast<char*>(&width), sizeof(width));
-    file.read(reinterpret_cast<char*>(&height), sizeof(height));
-    file.read(reinterpret_cast<char*>(&bits), sizeof(bits));
-    file.seekg(length + 1, std::ios::cur);
-
-    if (width == 0 || height == 0 || (bits != 24 && bits != 32 && bits != 16))
+    tImageTGA image = LoadTGA(path);
+    const std::vector<MipLevel> levels = GetMipLevels(image.sizeX, image.sizeY, image.channels);
+    image.data.resize(GetMipChainSize(levels, image.channels));
+    BuildMipChain(image.data.data(), levels, image.channels, image.data.data());
+
+    const BlockFormat format = ChooseBlockFormat(image.data.data(), levels[0].width * levels[0].height, image.channels);
+    if (!IsBlockFormatSupported(format))
     {
-        throw std::runtime_error("Error: Invalid TGA file: Unsupported dimensions or pixel format.");
+        Upload(image.sizeX, image.sizeY, image.channels, image.data.data(), levels);
+        return;
     }
 
-    int channels = bits / 8;
-    int stride = channels * width;
-    _localBuffer = std::make_unique<unsigned char[]>(stride * height);
+    const std::vector<unsigned char> blocks = CompressTexture(path, image, levels, format);
+    TextureCache::Write(path, key, format, image.sizeX, image.sizeY, blocks);
+    UploadCompressed(image.sizeX, image.sizeY, format, blocks.data(),
+                     GetCompressedLevels(image.sizeX, image.sizeY, format));
+}
 
-    if (imageType != 10)
-    { // Not RLE compressed
-        if (bits == 24 || bits == 32)
-        {
-            for (int y = 0; y < height; ++y)
-            {
-                unsigned char* pLine = &_localBuffer[stride * y];
-                file.read(reinterpret_cast<char*>(pLine), stride);
-                for (int i = 0; i < stride; i += channels)
-                {
-                    // Swap because TGA store in BGR order.
-                    std::swap(pLine[i], pLine[i + 2]);
-                }
-            }
-        }
-        else if (bits == 16)
+TextureOpenGL::TextureOpenGL()
+    : _residency(nullptr), _rendererID(0), _filePath(), _width(1), _height(1), _levelCount(1), _byteSize(4),
+      _ready(false), _evicted(false)
+{
+    CreatePlaceholder();
+}
+
+void TextureOpenGL::CreatePlaceholder()
+{
+    const unsigned char black[4] = {0, 0, 0, 255};
+
+    _width = 1;
+    _height = 1;
+    _levelCount = 1;
+    _byteSize = sizeof(black);
+
+    GlCall(glGenTextures(1, &_rendererID));
+    GlCall(glBindTexture(GL_TEXTURE_2D, _rendererID));
+
+    SetTextureFiltering(GL_TEXTURE_2D, false);
+    // GL REPEAT ensure that if a texture coordinates are not normalized, it will
+    // repeat it seamlessly.
+
+    GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+    GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+
+    GlCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, black));
+
+    GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+void TextureOpenGL::Upload(uint32_t width, uint32_t height, int channels, const void* pixels,
+                           std::span<const MipLevel> levels)
+{
+    GLenum format = (channels == 3) ? GL_RGB : GL_RGBA;
+    const std::size_t levelCount = std::max<std::size_t>(levels.size(), 1);
+    // Refills of a texture with frames of the same size, ex: video playback,
+    // keep the storage the driver already has.
+    const bool reuse = width == _width && height == _height && levelCount == _levelCount;
+
+    _width = width;
+    _height = height;
+    _levelCount = levelCount;
+
+    GlCall(glBindTexture(GL_TEXTURE_2D, _rendererID));
+
+    // RGB rows of an odd width are not 4-byte aligned.
+    GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+    // `pixels` may be an offset rather than a pointer.
+    std::size_t byteSize = 0;
+    for (std::size_t i = 0; i < levelCount; ++i)
+    {
+        const uint32_t levelWidth = i == 0 ? _width : levels[i].width;
+        const uint32_t levelHeight = i == 0 ? _height : levels[i].height;
+        const void* level =
+            i == 0 ? pixels : reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(pixels) + levels[i].offset);
+        // Stored as RGBA8 whatever the channels given.
+        byteSize += static_cast<std::size_t>(levelWidth) * levelHeight * 4;
+
+        if (reuse)
         {
-            unsigned short pixels = 0;
-            int r = 0, g = 0, b = 0;
-            channels = 3;
-            stride = channels * width;
-            for (int i = 0; i < width * height; ++i)
-            {
-                file.read(reinterpret_cast<char*>(&pixels), sizeof(pixels));
-                b = (pixels & 0x1f) << 3;
-                g = ((pixels >> 5) & 0x1f) << 3;
-                r = ((pixels >> 10) & 0x1f) << 3;
-                _localBuffer[i * 3 + 0] = r;
-                _localBuffer[i * 3 + 1] = g;
-                _localBuffer[i * 3 + 2] = b;
-            }
+            GlCall(glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, levelWidth, levelHeight, format, GL_UNSIGNED_BYTE, level));
         }
         else
         {
-            throw std::runtime_error("Error: Unsupported pixel format!");
+            GlCall(glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, levelWidth, levelHeight, 0, format, GL_UNSIGNED_BYTE,
+                                level));
         }
     }
-    else
-    { // RLE compressed
-        unsigned char rleID = 0;
-        int colorsRead = 0;
-        std::vector<unsigned char> pColors(channels);
-        while (colorsRead < width * height)
-        {
-            file.read(reinterpret_cast<char*>(&rleID), sizeof(rleID));
-            if (rleID < 128)
-            {
-                ++rleID;
-                while (rleID--)
-                {
-                    file.read(reinterpret_cast<char*>(pColors.data()), channels);
-                    for (int j = 0; j < channels; ++j)
-                    {
-                        _localBuffer[colorsRead * channels + j] = pColors[j];
-                    }
-                    if (channels == 4)
-                    {
-                        _localBuffer[colorsRead * channels + 3] = pColors[3];
-                    }
-                    ++colorsRead;
-                }
-            }
-            else
-            {
-                rleID -= 127;
-                file.read(reinterpret_cast<char*>(pColors.data()), channels);
-                while (rleID--)
-                {
-                    for (int j = 0; j < channels; ++j)
-                    {
-                        _localBuffer[colorsRead * channels + j] = pColors[j];
-                    }
-                    if (channels == 4)
-                    {
-                        _localBuffer[colorsRead * channels + 3] = pColors[3];
-                    }
-                    ++colorsRead;
-                }
-            }
-        }
+    GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+    // Reused storage keeps the parameters it was given.
+    if (!reuse)
+    {
+        const bool mipmapped = levelCount > 1;
+        GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+        SetTextureFiltering(GL_TEXTURE_2D, mipmapped);
     }
 
+    GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+    _byteSize = byteSize;
+    OnStorageChanged();
+}
+
+void TextureOpenGL::UploadCompressed(uint32_t width, uint32_t height, BlockFormat format, const unsigned char* blocks,
+                                     std::span<const MipLevel> levels)
+{
     _width = width;
     _height = height;
-    _BPP = bits;
-}
\ No newline at end of file
+    _levelCount = 0;
+
+    GLenum internalFormat = GL_COMPRESSED_RED_RGTC1;
+    if (format == BlockFormat::BC1)
+    {
+        internalFormat = COMPRESSED_RGB_S3TC_DXT1;
+    }
+    else if (format == BlockFormat::BC3)
+    {
+        internalFormat = COMPRESSED_RGBA_S3TC_DXT5;
+    }
+
+    GlCall(glBindTexture(GL_TEXTURE_2D, _rendererID));
+
+    for (std::size_t i = 0; i < levels.size(); ++i)
+    {
+        const std::size_t size =
+            static_cast<std::size_t>((levels[i].width + 3) / 4) * ((levels[i].height + 3) / 4) * GetBlockSize(format);
+        GlCall(glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, levels[i].width, levels[i].height, 0, size,
+                                      blocks + levels[i].offset));
+    }
+
+    // BC4 only has red, the shaders read gray.
+    if (format == BlockFormat::BC4)
+    {
+        const GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        GlCall(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle));
+    }
+
+    const bool mipmapped = levels.size() > 1;
+    GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmapped ? levels.size() - 1 : 0));
+    SetTextureFiltering(GL_TEXTURE_2D, mipmapped);
+
+    GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+    _byteSize = GetCompressedSize(levels, format);
+    OnStorageChanged();
+}
+
+void TextureOpenGL::OnStorageChanged()
+{
+    const bool reloaded = _evicted;
+
+    _ready = true;
+    _evicted = false;
+    if (_residency)
+    {
+        _residency->Resize(*this, _byteSize, reloaded);
+    }
+}
+
+void TextureOpenGL::Evict()
+{
+    // Deleting the texture is the only way to make sure the driver frees every
+    // level, a smaller glTexImage2D may keep them.
+    GlCall(glDeleteTextures(1, &_rendererID));
+    CreatePlaceholder();
+    _ready = false;
+    _evicted = true;
+}
+
+void TextureOpenGL::Reload()
+{
+    try
+    {
+        Load();
+    }
+    catch (const std::runtime_error& error)
+    {
+        // Keep the placeholder rather than trying again on every bind.
+        std::cerr << "Warning: cannot reload texture: " << error.what() << "\n";
+        _evicted = false;
+    }
+}
+
+TextureOpenGL::~TextureOpenGL()
+{
+    if (_residency)
+    {
+        _residency->Remove(*this);
+    }
+    GlCall(glDeleteTextures(1, &_rendererID));
+}
+
+void TextureOpenGL::Bind(unsigned int slot) const
+{
+    // An evicted texture loaded from a file reloads before being bound.
+    if (_residency)
+    {
+        _residency->Touch(*this);
+    }
+
+    GlCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GlCall(glBindTexture(GL_TEXTURE_2D, _rendererID));
+}
+
+void TextureOpenGL::Unbind()
+{
+}
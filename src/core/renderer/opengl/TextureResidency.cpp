@@ -0,0 +1,100 @@
+#include "renderer/opengl/TextureResidency.hpp"
+#include "renderer/opengl/TextureOpenGL.hpp"
+
+TextureResidency::TextureResidency(std::size_t budget) : _budget(budget)
+{
+}
+
+void TextureResidency::Add(TextureOpenGL& texture)
+{
+    if (_lookup.contains(&texture))
+    {
+        return;
+    }
+
+    _entries.push_back(Entry{&texture, texture.GetByteSize()});
+    _lookup[&texture] = std::prev(_entries.end());
+    _usedBytes += texture.GetByteSize();
+    texture.SetResidency(this);
+}
+
+void TextureResidency::Remove(const TextureOpenGL& texture)
+{
+    const auto it = _lookup.find(&texture);
+
+    if (it == _lookup.end())
+    {
+        return;
+    }
+
+    _usedBytes -= it->second->byteSize;
+    _entries.erase(it->second);
+    _lookup.erase(it);
+}
+
+void TextureResidency::SetPinned(const ITexture& texture, bool pinned)
+{
+    const auto it = _lookup.find(&texture);
+
+    if (it != _lookup.end())
+    {
+        it->second->pinned = pinned;
+    }
+}
+
+void TextureResidency::Touch(const TextureOpenGL& texture)
+{
+    const auto it = _lookup.find(&texture);
+
+    if (it == _lookup.end())
+    {
+        return;
+    }
+
+    _entries.splice(_entries.end(), _entries, it->second);
+
+    // Reloading calls Resize, which counts it.
+    TextureOpenGL& entryTexture = *it->second->texture;
+    if (entryTexture.IsEvicted() && entryTexture.HasFile())
+    {
+        entryTexture.Reload();
+    }
+}
+
+void TextureResidency::Resize(const TextureOpenGL& texture, std::size_t byteSize, bool reloaded)
+{
+    const auto it = _lookup.find(&texture);
+
+    if (it == _lookup.end())
+    {
+        return;
+    }
+
+    _usedBytes = _usedBytes - it->second->byteSize + byteSize;
+    it->second->byteSize = byteSize;
+    _entries.splice(_entries.end(), _entries, it->second);
+
+    if (reloaded)
+    {
+        ++_reloadCount;
+    }
+}
+
+void TextureResidency::Trim()
+{
+    for (auto it = _entries.begin(); it != _entries.end() && _usedBytes > _budget; ++it)
+    {
+        TextureOpenGL& texture = *it->texture;
+
+        // A placeholder has nothing worth releasing.
+        if (it->pinned || texture.IsEvicted() || !texture.IsReady())
+        {
+            continue;
+        }
+
+        texture.Evict();
+        _usedBytes = _usedBytes - it->byteSize + texture.GetByteSize();
+        it->byteSize = texture.GetByteSize();
+        ++_evictionCount;
+    }
+}
@@ -0,0 +1,38 @@
+#include "renderer/opengl/VertexBufferLayout.hpp"
+#include "renderer/opengl/RendererOpenGL.hpp"
+
+uint32_t VertexBufferElement::GetSizeOfType(uint32_t type)
+{
+    switch (type)
+    {
+    case GL_FLOAT:
+    case GL_UNSIGNED_INT:
+        return 4;
+    case GL_HALF_FLOAT:
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    }
+    ASSERT(false);
+    return 0;
+}
+
+void VertexBufferLayout::Push(uint32_t type, uint32_t count, bool normalized)
+{
+    _elements.push_back(VertexBufferElement{type, count, normalized, _stride});
+    _stride += count * VertexBufferElement::GetSizeOfType(type);
+}
+
+void VertexBufferLayout::Apply(uint32_t firstLocation) const
+{
+    for (uint32_t i = 0; i < _elements.size(); ++i)
+    {
+        const VertexBufferElement& element = _elements[i];
+
+        GlCall(glEnableVertexAttribArray(firstLocation + i));
+        GlCall(glVertexAttribPointer(firstLocation + i, element.count, element.type,
+                                     element.normalized ? GL_TRUE : GL_FALSE, _stride,
+                                     (const void*)(uintptr_t)element.offset));
+    }
+}
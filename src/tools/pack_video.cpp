@@ -0,0 +1,76 @@
+#include "ImageTGA.hpp"
+#include "MonoVideo.hpp"
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// Pack the frames 1.tga, 2.tga, ... of a directory into one video, see
+// MonoVideo.hpp.
+int main(int ac, char** av)
+{
+    if (ac != 3 && ac != 4)
+    {
+        std::cerr << "Error: Usage is <pack_video> <frame directory> <output" << MONO_VIDEO_EXTENSION
+                  << "> [frame rate]" << "\n";
+        return 1;
+    }
+
+    try
+    {
+        const std::filesystem::path directory(av[1]);
+        const uint32_t frameRate = ac == 4 ? std::stoul(av[3]) : 30;
+        if (frameRate == 0)
+        {
+            throw std::runtime_error("Error: The frame rate must be at least 1.");
+        }
+        std::unique_ptr<MonoVideoWriter> writer;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uintmax_t sourceSize = 0;
+        uint32_t frameCount = 0;
+
+        for (uint32_t i = 1;; ++i)
+        {
+            const std::filesystem::path path = directory / (std::to_string(i) + ".tga");
+            if (!std::filesystem::exists(path))
+            {
+                break;
+            }
+
+            const tImageTGA image = LoadTGA(path);
+            if (!writer)
+            {
+                width = image.sizeX;
+                height = image.sizeY;
+                writer = std::make_unique<MonoVideoWriter>(width, height, frameRate);
+            }
+            else if (static_cast<uint32_t>(image.sizeX) != width || static_cast<uint32_t>(image.sizeY) != height)
+            {
+                throw std::runtime_error("Error: Frame of another size: " + path.string());
+            }
+
+            writer->AddFrame(image.data.data(), image.channels);
+            sourceSize += std::filesystem::file_size(path);
+            ++frameCount;
+        }
+
+        if (!writer)
+        {
+            throw std::runtime_error("Error: No frame named 1.tga in " + directory.string());
+        }
+
+        writer->Write(av[2]);
+
+        const uintmax_t packedSize = std::filesystem::file_size(av[2]);
+        std::cout << "Packed " << frameCount << " frames of " << width << "x" << height << ", "
+                  << writer->GetKeyframeCount() << " keyframes: " << sourceSize / 1024 << " KiB -> "
+                  << packedSize / 1024 << " KiB\n";
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+}
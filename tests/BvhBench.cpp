@@ -0,0 +1,139 @@
+#include "MeshBvh.hpp"
+#include "Model.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Build time of the hierarchy of a model and the rays per second it answers on
+// one thread, for rays cast from a camera and rays in random directions.
+
+namespace
+{
+
+struct Ray
+{
+    Vector3 origin;
+    Vector3 direction;
+};
+
+// From a camera outside the bounding sphere, through a grid covering it. Neighbor
+// rays visit the same nodes, like picking under a moving cursor.
+std::vector<Ray> MakeCameraRays(const Vector3& center, float radius, std::size_t count)
+{
+    const std::size_t side = std::max<std::size_t>(std::sqrt(count), 1);
+    const Vector3 eye(center.x, center.y, center.z + radius * 3.0f);
+    std::vector<Ray> rays;
+
+    rays.reserve(side * side);
+    for (std::size_t y = 0; y < side; ++y)
+    {
+        for (std::size_t x = 0; x < side; ++x)
+        {
+            const float u = (x + 0.5f) / side * 2.0f - 1.0f;
+            const float v = (y + 0.5f) / side * 2.0f - 1.0f;
+            const Vector3 target(center.x + u * radius, center.y + v * radius, center.z);
+            rays.push_back(Ray{eye, Vector3(target.x - eye.x, target.y - eye.y, target.z - eye.z)});
+        }
+    }
+    return rays;
+}
+
+// From random points around the bounding sphere to random points in its cube,
+// so consecutive rays share no node below the root.
+std::vector<Ray> MakeRandomRays(const Vector3& center, float radius, std::size_t count)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays(count);
+
+    for (Ray& ray : rays)
+    {
+        Vector3 side(unit(random), unit(random), unit(random));
+        const float length = std::max(std::sqrt(side.x * side.x + side.y * side.y + side.z * side.z), 1e-6f);
+        side = Vector3(side.x / length, side.y / length, side.z / length);
+
+        ray.origin = Vector3(center.x + side.x * radius * 2.0f, center.y + side.y * radius * 2.0f,
+                             center.z + side.z * radius * 2.0f);
+        const Vector3 target(center.x + unit(random) * radius, center.y + unit(random) * radius,
+                             center.z + unit(random) * radius);
+        ray.direction = Vector3(target.x - ray.origin.x, target.y - ray.origin.y, target.z - ray.origin.z);
+    }
+    return rays;
+}
+
+void Trace(const MeshBvh& bvh, const std::vector<Ray>& rays, const char* name)
+{
+    std::size_t hitCount = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (const Ray& ray : rays)
+    {
+        RayHit hit;
+        hitCount += bvh.Intersect(ray.origin, ray.direction, std::numeric_limits<float>::max(), hit);
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << rays.size() / seconds / 1e6 << " Mrays/s, " << 100.0 * hitCount / rays.size()
+              << "% hit\n";
+}
+
+double GetSecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int ac, char** av)
+{
+    if (ac != 2 && ac != 3)
+    {
+        std::cerr << "Error: Usage is <bvh_bench> <.obj> [ray count]" << "\n";
+        return 1;
+    }
+
+    try
+    {
+        const uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        const std::size_t rayCount = ac == 3 ? std::stoul(av[2]) : 1000000;
+
+        ModelLoadOptions options;
+        options.threadCount = threadCount;
+        options.useCache = false;
+        const Model model(av[1], options);
+        const std::span<const uint32_t> indices = model.GetIndexData().first(model.GetLods()[0].indexCount);
+
+        if (indices.empty())
+        {
+            throw std::runtime_error("Error: no triangle in " + std::string(av[1]));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        const MeshBvh serial(indices, model.GetVertexData(), 5, 1);
+        const double serialSeconds = GetSecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        const MeshBvh bvh(indices, model.GetVertexData(), 5, threadCount);
+        const double parallelSeconds = GetSecondsSince(start);
+
+        std::cout << indices.size() / 3 << " triangles, " << bvh.GetNodes().size() << " nodes, "
+                  << bvh.GetMemoryUsage() / (1024.0 * 1024.0) << " MiB\n"
+                  << "build: " << serialSeconds * 1e3 << " ms on 1 thread, " << parallelSeconds * 1e3 << " ms on "
+                  << threadCount << "\n";
+
+        Trace(bvh, MakeCameraRays(model._sphereCenter, model._sphereRadius, rayCount), "camera rays");
+        Trace(bvh, MakeRandomRays(model._sphereCenter, model._sphereRadius, rayCount), "random rays");
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+}
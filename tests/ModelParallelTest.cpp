@@ -0,0 +1,144 @@
+#include "Model.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// Loads one OBJ serially and split in chunks parsed in parallel, and checks
+// the buffers are byte-identical, see ModelLoadOptions::threadCount.
+
+namespace
+{
+
+// Rows of the generated grid, enough for the file to span several chunks of
+// MIN_CHUNK_SIZE.
+constexpr int GRID_SIZE = 700;
+
+// Every few rows start a group and a material, some names repeat so runs far
+// apart in the file merge in one submesh.
+constexpr int ROWS_PER_GROUP = 37;
+
+// A grid of quads and triangles in groups, with the faces of odd rows written
+// before the vertices of the next row.
+void WriteGrid(const std::filesystem::path& path)
+{
+    std::ofstream file(path);
+    char line[128];
+
+    if (!file)
+    {
+        throw std::runtime_error("Error: could not write " + path.string());
+    }
+
+    file << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+
+    const auto vertex = [](int x, int y) { return y * GRID_SIZE + x + 1; };
+    const auto writeFaces = [&](int y) {
+        if (y % ROWS_PER_GROUP == 0)
+        {
+            file << "g part" << (y / ROWS_PER_GROUP) % 5 << "\nusemtl color" << (y / ROWS_PER_GROUP) % 3 << "\n";
+        }
+        for (int x = 0; x + 1 < GRID_SIZE; ++x)
+        {
+            if (x % 3 == 0)
+            {
+                std::snprintf(line, sizeof(line), "f %d/1 %d/2 %d/3 %d/4\n", vertex(x, y), vertex(x + 1, y),
+                              vertex(x + 1, y + 1), vertex(x, y + 1));
+            }
+            else
+            {
+                std::snprintf(line, sizeof(line), "f %d/1 %d/2 %d/3\nf %d/1 %d/3 %d/4\n", vertex(x, y),
+                              vertex(x + 1, y), vertex(x + 1, y + 1), vertex(x, y), vertex(x + 1, y + 1),
+                              vertex(x, y + 1));
+            }
+            file << line;
+        }
+    };
+
+    for (int y = 0; y < GRID_SIZE; ++y)
+    {
+        for (int x = 0; x < GRID_SIZE; ++x)
+        {
+            std::snprintf(line, sizeof(line), "v %f %f %f\n", x * 0.01f, y * 0.01f, ((x * 7 + y * 13) % 17) * 0.001f);
+            file << line;
+        }
+        if (y % 2 == 1)
+        {
+            writeFaces(y - 1);
+            if (y + 1 < GRID_SIZE)
+            {
+                writeFaces(y);
+            }
+        }
+    }
+}
+
+template <typename T> bool IsSame(std::span<const T> serial, std::span<const T> parallel)
+{
+    return serial.size() == parallel.size() && std::equal(serial.begin(), serial.end(), parallel.begin());
+}
+
+bool IsSame(const Model& serial, const Model& parallel)
+{
+    if (!IsSame(serial.GetVertexData(), parallel.GetVertexData()) ||
+        !IsSame(serial.GetIndexData(), parallel.GetIndexData()) ||
+        serial.GetSubmeshes().size() != parallel.GetSubmeshes().size())
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < serial.GetSubmeshes().size(); ++i)
+    {
+        const MeshRange& serialRange = serial.GetSubmeshRange(0, i);
+        const MeshRange& parallelRange = parallel.GetSubmeshRange(0, i);
+
+        if (serial.GetSubmeshName(i) != parallel.GetSubmeshName(i) ||
+            serial.GetSubmeshMaterial(i) != parallel.GetSubmeshMaterial(i) ||
+            serialRange.indexOffset != parallelRange.indexOffset || serialRange.indexCount != parallelRange.indexCount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "scop_model_parallel_test.obj";
+    int result = 0;
+
+    try
+    {
+        WriteGrid(path);
+
+        ModelLoadOptions options;
+        options.useCache = false;
+        const Model serial(path.string(), options);
+
+        for (const uint32_t threadCount : {2u, 3u, 8u})
+        {
+            options.threadCount = threadCount;
+            const Model parallel(path.string(), options);
+
+            if (!IsSame(serial, parallel))
+            {
+                std::cerr << "Error: " << threadCount << " threads differ from the serial load\n";
+                result = 1;
+            }
+        }
+        std::cout << serial.GetIndexData().size() / 3 << " triangles, " << serial.GetSubmeshes().size()
+                  << " submeshes\n";
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << "\n";
+        result = 1;
+    }
+
+    std::filesystem::remove(path);
+    return result;
+}
@@ -0,0 +1,165 @@
+#include "ImageTGA.hpp"
+#include "TGATestImage.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Decode speed of RLE TGA files against the decoder DecodeTGA replaced, which
+// read every packet and pixel through an ifstream. Output throughput in MB/s,
+// the best of a few runs.
+//
+// tga_decode_bench [size], 4096 by default, for size x size images.
+
+namespace
+{
+
+// Runs of each decoder, the best time is kept.
+constexpr int BENCH_RUNS = 3;
+
+// The RLE path of the former LoadTGA, as it was. It leaves pixels in BGR(A)
+// order and has no 16-bit RLE support, it is only timed.
+tImageTGA LoadRLETGABaseline(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error: unable to load TGA File!");
+    }
+
+    unsigned char length = 0;
+    unsigned char imageType = 0;
+    unsigned char bits = 0;
+    unsigned short width = 0, height = 0;
+
+    file.read(reinterpret_cast<char*>(&length), sizeof(length));
+    file.seekg(1, std::ios::cur);
+    file.read(reinterpret_cast<char*>(&imageType), sizeof(imageType));
+    file.seekg(9, std::ios::cur);
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    file.read(reinterpret_cast<char*>(&bits), sizeof(bits));
+    file.seekg(length + 1, std::ios::cur);
+
+    if (imageType != 10 || (bits != 24 && bits != 32))
+    {
+        throw std::runtime_error("Error: baseline only decodes 24 and 32-bit RLE.");
+    }
+
+    int channels = bits / 8;
+    tImageTGA image;
+    image.data.resize(static_cast<std::size_t>(channels) * width * height);
+
+    unsigned char rleID = 0;
+    int colorsRead = 0;
+    std::vector<unsigned char> pColors(channels);
+    while (colorsRead < width * height)
+    {
+        file.read(reinterpret_cast<char*>(&rleID), sizeof(rleID));
+        if (rleID < 128)
+        {
+            ++rleID;
+            while (rleID--)
+            {
+                file.read(reinterpret_cast<char*>(pColors.data()), channels);
+                for (int j = 0; j < channels; ++j)
+                {
+                    image.data[colorsRead * channels + j] = pColors[j];
+                }
+                if (channels == 4)
+                {
+                    image.data[colorsRead * channels + 3] = pColors[3];
+                }
+                ++colorsRead;
+            }
+        }
+        else
+        {
+            rleID -= 127;
+            file.read(reinterpret_cast<char*>(pColors.data()), channels);
+            while (rleID--)
+            {
+                for (int j = 0; j < channels; ++j)
+                {
+                    image.data[colorsRead * channels + j] = pColors[j];
+                }
+                if (channels == 4)
+                {
+                    image.data[colorsRead * channels + 3] = pColors[3];
+                }
+                ++colorsRead;
+            }
+        }
+    }
+
+    image.channels = channels;
+    image.sizeX = width;
+    image.sizeY = height;
+    return image;
+}
+
+template <typename Function> double GetBestSeconds(Function function)
+{
+    double best = 0.0;
+
+    for (int i = 0; i < BENCH_RUNS; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int ac, char** av)
+{
+    if (ac > 2)
+    {
+        std::cerr << "Error: Usage is <tga_decode_bench> [size]" << "\n";
+        return 1;
+    }
+
+    try
+    {
+        const int size = ac == 2 ? std::stoi(av[1]) : 4096;
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "scop_tga_decode_bench.tga";
+
+        for (const int bits : {32, 24, 16})
+        {
+            const TGATestImage image = MakeTGATestImage(size, size, bits, true, bits);
+            const double megabytes = image.pixels.size() / (1024.0 * 1024.0);
+
+            const tImageTGA decoded = DecodeTGA(image.file.data(), image.file.size());
+            if (decoded.data != image.pixels)
+            {
+                throw std::runtime_error("Error: " + std::to_string(bits) + "-bit RLE decodes wrong");
+            }
+
+            const double seconds = GetBestSeconds([&] { DecodeTGA(image.file.data(), image.file.size()); });
+            std::cout << bits << "-bit RLE " << size << "x" << size << ": " << megabytes / seconds << " MB/s";
+
+            if (bits != 16)
+            {
+                std::ofstream(path, std::ios::binary)
+                    .write(reinterpret_cast<const char*>(image.file.data()), image.file.size());
+                const double baseline = GetBestSeconds([&] { LoadRLETGABaseline(path.string()); });
+                std::cout << ", baseline " << megabytes / baseline << " MB/s, " << baseline / seconds << "x";
+            }
+            std::cout << "\n";
+        }
+
+        std::filesystem::remove(path);
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+}
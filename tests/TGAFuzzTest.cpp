@@ -0,0 +1,147 @@
+#include "ImageTGA.hpp"
+#include "MappedFile.hpp"
+#include "TGATestImage.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Decodes mutated TGA files, each must either decode or be rejected with a
+// std::runtime_error. A crash fails the test too, an ASan build also catches
+// reads and writes out of bounds that do not crash.
+//
+// The seeds are small generated files of every supported format, and the .tga
+// files of an optional corpus directory, first decoded as they are. Mutations
+// are drawn from a fixed seed, a failure repeats on every run.
+
+namespace
+{
+
+std::vector<unsigned char> Mutate(std::vector<unsigned char> file, std::mt19937& random)
+{
+    const int mutations = random() % 8 + 1;
+
+    for (int i = 0; i < mutations && !file.empty(); ++i)
+    {
+        switch (random() % 5)
+        {
+        case 0:
+            file[random() % file.size()] ^= 1 << (random() % 8);
+            break;
+        case 1:
+            file[random() % file.size()] = random();
+            break;
+        case 2:
+            file.resize(random() % (file.size() + 1));
+            break;
+        case 3:
+            file.insert(file.begin() + random() % file.size(), random());
+            break;
+        default:
+            // The image type, size and pixel depth of the header.
+            file[std::min<std::size_t>(2 + random() % 15, file.size() - 1)] = random();
+            break;
+        }
+    }
+    return file;
+}
+
+// True if decoded or rejected as expected.
+bool Decode(const std::vector<unsigned char>& file)
+{
+    try
+    {
+        DecodeTGA(file.data(), file.size());
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "Error: unexpected exception: " << error.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int ac, char** av)
+{
+    if (ac != 2 && ac != 3)
+    {
+        std::cerr << "Error: Usage is <tga_fuzz_test> <iterations> [corpus directory]" << "\n";
+        return 1;
+    }
+
+    try
+    {
+        const unsigned long iterations = std::stoul(av[1]);
+        std::vector<std::vector<unsigned char>> seeds;
+        bool failed = false;
+
+        for (const int bits : {16, 24, 32})
+        {
+            for (const bool compressed : {false, true})
+            {
+                const TGATestImage image = MakeTGATestImage(bits + 1, 7, bits, compressed, bits);
+                const tImageTGA decoded = DecodeTGA(image.file.data(), image.file.size());
+
+                if (decoded.data != image.pixels || decoded.channels != image.channels)
+                {
+                    std::cerr << "Error: " << bits << "-bit " << (compressed ? "RLE" : "raw")
+                              << " seed decodes wrong\n";
+                    failed = true;
+                }
+                seeds.push_back(image.file);
+            }
+        }
+
+        if (ac == 3)
+        {
+            for (const auto& entry : std::filesystem::directory_iterator(av[2]))
+            {
+                if (entry.path().extension() != ".tga")
+                {
+                    continue;
+                }
+
+                const MappedFile file(entry.path().string());
+                const unsigned char* data = reinterpret_cast<const unsigned char*>(file.GetData());
+                seeds.emplace_back(data, data + file.GetSize());
+
+                if (!Decode(seeds.back()))
+                {
+                    std::cerr << "Error: " << entry.path().string() << "\n";
+                    failed = true;
+                }
+            }
+        }
+
+        std::mt19937 random(1);
+        for (unsigned long i = 0; i < iterations; ++i)
+        {
+            const std::vector<unsigned char> file = Mutate(seeds[random() % seeds.size()], random);
+
+            if (!Decode(file))
+            {
+                std::ofstream("tga_fuzz_failure.tga", std::ios::binary)
+                    .write(reinterpret_cast<const char*>(file.data()), file.size());
+                std::cerr << "Error: iteration " << i << ", written to tga_fuzz_failure.tga\n";
+                failed = true;
+            }
+        }
+
+        std::cout << iterations << " mutated files from " << seeds.size() << " seeds\n";
+        return failed ? 1 : 0;
+    }
+    catch (std::exception& ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Random TGA files for the TGA tests and benchmarks, with the pixels DecodeTGA
+// should produce from them.
+struct TGATestImage
+{
+    std::vector<unsigned char> file;
+    std::vector<unsigned char> pixels;
+    int channels;
+};
+
+// Runs of one pixel and runs of random pixels, so RLE files hold both repeat
+// and raw packets. 16, 24 or 32 bits per pixel.
+inline TGATestImage MakeTGATestImage(int width, int height, int bits, bool compressed, uint32_t seed)
+{
+    const std::size_t pixelSize = bits / 8;
+    const std::size_t count = static_cast<std::size_t>(width) * height;
+    std::mt19937 random(seed);
+
+    std::vector<unsigned char> source(count * pixelSize);
+    for (std::size_t i = 0; i < count;)
+    {
+        const std::size_t run = random() % 40 + 1;
+        const bool repeat = random() % 2;
+        const unsigned char color[4] = {static_cast<unsigned char>(random()), static_cast<unsigned char>(random()),
+                                        static_cast<unsigned char>(random()), static_cast<unsigned char>(random())};
+
+        for (std::size_t k = 0; k < run && i < count; ++k, ++i)
+        {
+            for (std::size_t j = 0; j < pixelSize; ++j)
+            {
+                source[i * pixelSize + j] = repeat ? color[j] : static_cast<unsigned char>(random());
+            }
+        }
+    }
+
+    // Image type, then width, height and bits per pixel.
+    unsigned char header[18] = {};
+    header[2] = compressed ? 10 : 2;
+    header[12] = width & 0xff;
+    header[13] = width >> 8;
+    header[14] = height & 0xff;
+    header[15] = height >> 8;
+    header[16] = bits;
+
+    // A packet byte per pixel at worst.
+    TGATestImage image;
+    image.file.reserve(sizeof(header) + source.size() + count);
+    image.file.assign(header, header + sizeof(header));
+
+    const auto isSame = [&](std::size_t a, std::size_t b) {
+        return std::memcmp(&source[a * pixelSize], &source[b * pixelSize], pixelSize) == 0;
+    };
+
+    if (!compressed)
+    {
+        image.file.insert(image.file.end(), source.begin(), source.end());
+    }
+    for (std::size_t i = 0; compressed && i < count;)
+    {
+        std::size_t run = 1;
+        while (i + run < count && run < 128 && isSame(i, i + run))
+        {
+            ++run;
+        }
+
+        // A raw packet stops before the next repeat.
+        const bool repeat = run > 1;
+        if (!repeat)
+        {
+            while (i + run < count && run < 128 && (i + run + 1 >= count || !isSame(i + run, i + run + 1)))
+            {
+                ++run;
+            }
+        }
+
+        image.file.push_back(static_cast<unsigned char>((repeat ? 0x80 : 0) | (run - 1)));
+        image.file.insert(image.file.end(), &source[i * pixelSize], &source[(i + (repeat ? 1 : run)) * pixelSize]);
+        i += run;
+    }
+
+    // RGB(A) from BGR(A), and 16-bit A1R5G5B5 to opaque RGBA with the top bits
+    // of each channel repeated in the bottom ones.
+    image.channels = bits == 24 ? 3 : 4;
+    image.pixels.resize(count * image.channels);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        unsigned char* pixel = &image.pixels[i * image.channels];
+        const unsigned char* from = &source[i * pixelSize];
+
+        if (bits == 16)
+        {
+            const unsigned value = from[0] | (from[1] << 8);
+            const auto expand = [](unsigned channel) {
+                return static_cast<unsigned char>((channel << 3) | (channel >> 2));
+            };
+            pixel[0] = expand((value >> 10) & 0x1f);
+            pixel[1] = expand((value >> 5) & 0x1f);
+            pixel[2] = expand(value & 0x1f);
+            pixel[3] = 255;
+        }
+        else
+        {
+            pixel[0] = from[2];
+            pixel[1] = from[1];
+            pixel[2] = from[0];
+            if (bits == 32)
+            {
+                pixel[3] = from[3];
+            }
+        }
+    }
+    return image;
+}